@@ -0,0 +1,457 @@
+#include "benchmark.h"
+#include <compact_dawg.h>
+#include <compact_datrie.h>
+#include <cstdlib>
+#include <cstring>
+#include <darts_wrapper.h>
+#include <dawg_datrie_builder.h>
+#include <datrie_builder.h>
+#include <dawg.h>
+#include <flat_compact_dawg.h>
+#include <default_datrie.h>
+#include <hashtrie.h>
+#include <huge_page_allocator.h>
+#include <htrie_wrapper.h>
+#include <levenshtein.h>
+#include <loader.h>
+#include <memory>
+#include <no_value_datrie.h>
+#include <packed_datrie.h>
+#include <serializers/compact_serializer.h>
+#include <serializers/default_serializer.h>
+#include <serializers/no_value_serializer.h>
+#include <serializers/packed_serializer.h>
+#include <serializers/wide_serializer.h>
+#include <sstream>
+#include <utf8_datrie.h>
+#include <workload.h>
+
+using namespace xtrie;
+using namespace xtrie::bench;
+
+namespace {
+
+struct Options {
+  size_t repetitions = 5;
+  size_t n_queries = 100000;
+  Format format = Format::Table;
+  bool counters = true;
+  uint32_t fuzzy = 0; // max edits, no fuzzy search if 0
+  size_t n_fuzzy_queries = 200;
+  unsigned max_threads = 0;          // no scaling runs if 0
+  std::vector<std::string> backends; // all if empty
+  std::vector<std::string> lexicons;
+};
+
+struct Dataset {
+  Dataset(std::string name, std::vector<std::string> words,
+          const Options &options)
+      : name(std::move(name)), words(std::move(words)),
+        hits("hit", zipf_queries(this->words, options.n_queries)),
+        misses("miss", miss_queries(this->words, options.n_queries)) {
+    for (uint32_t k = 1; k <= options.fuzzy; ++k) {
+      typos.push_back(std::make_unique<QuerySet>(
+          "fuzzy" + std::to_string(k),
+          typo_queries(this->words, options.n_fuzzy_queries, k)));
+    }
+    for (unsigned t = 0; t < options.max_threads; ++t) {
+      streams.push_back(std::make_unique<QuerySet>(
+          "hit", zipf_queries(this->words, options.n_queries, 1.0, 42 + t)));
+    }
+  }
+
+  std::string name;
+  std::vector<std::string> words; // sorted
+  QuerySet hits;
+  QuerySet misses;
+  // typos[k - 1] are searched within k edits
+  std::vector<std::unique_ptr<QuerySet>> typos;
+  // hits of every thread of the scaling runs, drawn with their own seeds
+  std::vector<std::unique_ptr<QuerySet>> streams;
+};
+
+template <typename Trie>
+concept HasFuzzySearch = requires(const Trie &trie, std::string_view q) {
+  trie.fuzzy_search(q, 1u, [](std::string_view, auto, uint32_t) {});
+};
+
+template <IsTrieBuilder Builder>
+void add_words(Builder &builder, const std::vector<std::string> &words) {
+  using value_type = typename Builder::value_type;
+
+  // values start from 1, 0 is the default value of some tries
+  for (size_t i = 0; i < words.size(); ++i) {
+    builder.add(words[i], static_cast<value_type>(i + 1));
+  }
+
+  if constexpr (IsStaticTrieBuilder<Builder>) {
+    builder.end_build();
+  }
+}
+
+//! @tparam Serializer void for a builder with its own format, saved by
+//! builder.save(os)
+template <IsDeserializableTrie Trie, IsStaticTrieBuilder Builder,
+          typename Serializer>
+void load_words(Trie &trie, const std::vector<std::string> &words) {
+  std::stringstream ss;
+  {
+    Builder builder;
+    add_words(builder, words);
+    if constexpr (std::is_void_v<Serializer>) {
+      builder.save(ss);
+    } else {
+      builder.save(ss, Serializer{});
+    }
+  }
+  trie.load(ss);
+}
+
+struct Context {
+  const Options &options;
+  PerfCounters &perf;
+  Reporter &reporter;
+};
+
+//! @param search called as search(query, max edits), returns the matches
+template <typename F>
+void run_fuzzy(const char *backend, const Dataset &dataset, Context &ctx,
+               F &&search) {
+  for (uint32_t k = 1; k <= dataset.typos.size(); ++k) {
+    auto m = measure_queries(
+        *dataset.typos[k - 1], ctx.options.repetitions, ctx.perf,
+        [&](std::string_view q) { return search(q, k); });
+    m.backend = backend;
+    m.dataset = dataset.name;
+    ctx.reporter.report(m);
+  }
+}
+
+template <IsTrie Trie>
+void run(const char *backend, const Trie &trie, const Dataset &dataset,
+         Context &ctx) {
+  for (auto *qs : {&dataset.hits, &dataset.misses}) {
+    auto m = measure(trie, *qs, ctx.options.repetitions, ctx.perf);
+    m.backend = backend;
+    m.dataset = dataset.name;
+    ctx.reporter.report(m);
+  }
+
+  if constexpr (HasFuzzySearch<Trie>) {
+    run_fuzzy(backend, dataset, ctx, [&](std::string_view q, uint32_t k) {
+      size_t n = 0;
+      trie.fuzzy_search(q, k, [&](std::string_view, auto, uint32_t) { ++n; });
+      return n;
+    });
+  }
+}
+
+//! @brief Lookups in one trie shared by 1, 2, 4... up to max_threads
+//! threads, each with its own stream of hits
+template <IsTrie Trie>
+void run_scaling(const char *backend, const Trie &trie,
+                 const Dataset &dataset, Context &ctx) {
+  std::vector<unsigned> counts;
+  for (unsigned n = 1; n < ctx.options.max_threads; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(ctx.options.max_threads);
+
+  for (unsigned n : counts) {
+    std::vector<const QuerySet *> query_sets;
+    for (unsigned t = 0; t < n; ++t) {
+      query_sets.push_back(dataset.streams[t].get());
+    }
+
+    auto m = measure_threads(query_sets, ctx.options.repetitions,
+                             ctx.options.counters, [&](std::string_view q) {
+                               return static_cast<size_t>(lookup(trie, q));
+                             });
+    m.backend = backend;
+    m.dataset = dataset.name;
+    ctx.reporter.report(m);
+  }
+}
+
+//! @brief Fuzzy search by running the automaton over every word, the
+//! baseline of the tries
+void run_brute_force(const Dataset &dataset, Context &ctx) {
+  std::vector<uint32_t> rows;
+
+  run_fuzzy("brute_force", dataset, ctx, [&](std::string_view q, uint32_t k) {
+    LevenshteinAutomaton automaton(q, k);
+    size_t w = automaton.row_size();
+    rows.resize(2 * w);
+
+    size_t n = 0;
+    for (auto &word : dataset.words) {
+      uint32_t *row = rows.data(), *next = row + w;
+      automaton.start(row);
+
+      bool alive = true;
+      for (size_t i = 0; alive && i < word.size(); ++i) {
+        alive = automaton.step(row, next, i, word[i]);
+        std::swap(row, next);
+      }
+      n += alive && automaton.accepts(row);
+    }
+    return n;
+  });
+}
+
+bool selected(const Options &options, const char *backend) {
+  return options.backends.empty() ||
+         std::find(options.backends.begin(), options.backends.end(),
+                   backend) != options.backends.end();
+}
+
+void run_all(const Dataset &dataset, Context &ctx) {
+  // every trie is destroyed before the next is built, so they don't share
+  // the cache and the heap
+
+  if (selected(ctx.options, "hashtrie")) {
+    HashTrie<> trie;
+    add_words(trie, dataset.words);
+    run("hashtrie", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "dawg")) {
+    DAWG<> trie;
+    add_words(trie, dataset.words);
+    run("dawg", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "compact_dawg")) {
+    CompactDAWG<> trie;
+    add_words(trie, dataset.words);
+    run("compact_dawg", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "flat_compact_dawg")) {
+    FlatCompactDAWG<> trie;
+    {
+      CompactDAWG<> dawg;
+      add_words(dawg, dataset.words);
+      trie.build(dawg);
+    }
+    run("flat_compact_dawg", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "default_datrie")) {
+    DefaultDoubleArrayTrie<> trie;
+    load_words<decltype(trie), DoubleArrayTrieBuilder<>, DefaultSerializer>(
+        trie, dataset.words);
+    run("default_datrie", trie, dataset, ctx);
+    if (ctx.options.max_threads > 0)
+      run_scaling("default_datrie", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "compact_datrie")) {
+    CompactDoubleArrayTrie<> trie;
+    load_words<decltype(trie), DoubleArrayTrieBuilder<uint32_t, 0, true>,
+               CompactSerializer>(trie, dataset.words);
+    run("compact_datrie", trie, dataset, ctx);
+    if (ctx.options.max_threads > 0)
+      run_scaling("compact_datrie", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "dawg_datrie")) {
+    DawgDoubleArrayTrie<> trie;
+    load_words<decltype(trie), DawgDoubleArrayTrieBuilder<>, void>(
+        trie, dataset.words);
+    run("dawg_datrie", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "packed_datrie")) {
+    PackedDoubleArrayTrie<> trie;
+    load_words<decltype(trie), DoubleArrayTrieBuilder<>, PackedSerializer<>>(
+        trie, dataset.words);
+    run("packed_datrie", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "default_datrie_rec")) {
+    DefaultDoubleArrayTrie<int, -1, NoAccessProfile, std::allocator,
+                           InterleavedLayout>
+        trie;
+    load_words<decltype(trie), DoubleArrayTrieBuilder<>, DefaultSerializer>(
+        trie, dataset.words);
+    run("default_datrie_rec", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "default_datrie64")) {
+    DefaultDoubleArrayTrie<int64_t, -1> trie;
+    load_words<decltype(trie), DoubleArrayTrieBuilder<int64_t, -1>,
+               DefaultSerializer>(trie, dataset.words);
+    run("default_datrie64", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "default_datrie64_rec")) {
+    DefaultDoubleArrayTrie<int64_t, -1, NoAccessProfile, std::allocator,
+                           InterleavedLayout>
+        trie;
+    load_words<decltype(trie), DoubleArrayTrieBuilder<int64_t, -1>,
+               DefaultSerializer>(trie, dataset.words);
+    run("default_datrie64_rec", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "default_datrie_thp")) {
+    DefaultDoubleArrayTrie<int, -1, NoAccessProfile, HugePageAllocator> trie;
+    load_words<decltype(trie), DoubleArrayTrieBuilder<>, DefaultSerializer>(
+        trie, dataset.words);
+    run("default_datrie_thp", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "compact_datrie_thp")) {
+    CompactDoubleArrayTrie<uint32_t, 0, NoAccessProfile, HugePageAllocator>
+        trie;
+    load_words<decltype(trie), DoubleArrayTrieBuilder<uint32_t, 0, true>,
+               CompactSerializer>(trie, dataset.words);
+    run("compact_datrie_thp", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "no_value_datrie")) {
+    NoValueDoubleArrayTrie<> trie;
+    load_words<decltype(trie), DoubleArrayTrieBuilder<>, NoValueSerializer>(
+        trie, dataset.words);
+    run("no_value_datrie", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "utf8_datrie")) {
+    Utf8DoubleArrayTrie<> trie;
+    load_words<decltype(trie),
+               DoubleArrayTrieBuilder<int, -1, false, Utf8Alphabet>,
+               WideSerializer>(trie, dataset.words);
+    run("utf8_datrie", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "darts")) {
+    DartsWrapper trie;
+    add_words(trie, dataset.words);
+    run("darts", trie, dataset, ctx);
+  }
+
+  if (selected(ctx.options, "htrie")) {
+    KVHTrieWrapper trie;
+    add_words(trie, dataset.words);
+    run("htrie", trie, dataset, ctx);
+  }
+
+  if (!dataset.typos.empty() && selected(ctx.options, "brute_force")) {
+    run_brute_force(dataset, ctx);
+  }
+}
+
+[[noreturn]] void usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s [--reps N] [--queries N] [--format table|csv|json]\n"
+          "          [--no-counters] [--fuzzy MAX_EDITS] [--fuzzy-queries N]\n"
+          "          [--threads MAX] [--backend NAME]... [LEXICON]...\n"
+          "\n"
+          "backends: hashtrie dawg compact_dawg flat_compact_dawg\n"
+          "          default_datrie compact_datrie dawg_datrie packed_datrie\n"
+          "          default_datrie_rec default_datrie64 "
+          "default_datrie64_rec\n"
+          "          default_datrie_thp compact_datrie_thp no_value_datrie\n"
+          "          utf8_datrie darts htrie brute_force\n"
+          "*_rec keep every value next to its unit (InterleavedLayout), *64 "
+          "have\n"
+          "64-bit values, *_thp put their arrays on transparent huge pages\n"
+          "brute_force only runs the fuzzy search\n"
+          "--threads MAX shares default_datrie and compact_datrie between\n"
+          "1, 2, 4... MAX threads\n"
+          "lexicons default to the ones under " DATA_DIR "\n",
+          argv0);
+  exit(1);
+}
+
+Options parse_options(int argc, char **argv) {
+  Options options;
+
+  for (int i = 1; i < argc; ++i) {
+    auto arg = std::string_view(argv[i]);
+    auto value = [&] {
+      if (i + 1 == argc)
+        usage(argv[0]);
+      return std::string_view(argv[++i]);
+    };
+
+    if (arg == "--reps") {
+      options.repetitions = std::strtoull(value().data(), nullptr, 10);
+    } else if (arg == "--queries") {
+      options.n_queries = std::strtoull(value().data(), nullptr, 10);
+    } else if (arg == "--format") {
+      auto format = value();
+      if (format == "table")
+        options.format = Format::Table;
+      else if (format == "csv")
+        options.format = Format::Csv;
+      else if (format == "json")
+        options.format = Format::Json;
+      else
+        usage(argv[0]);
+    } else if (arg == "--no-counters") {
+      options.counters = false;
+    } else if (arg == "--fuzzy") {
+      options.fuzzy =
+          static_cast<uint32_t>(std::strtoul(value().data(), nullptr, 10));
+    } else if (arg == "--fuzzy-queries") {
+      options.n_fuzzy_queries = std::strtoull(value().data(), nullptr, 10);
+    } else if (arg == "--threads") {
+      options.max_threads =
+          static_cast<unsigned>(std::strtoul(value().data(), nullptr, 10));
+    } else if (arg == "--backend") {
+      options.backends.emplace_back(value());
+    } else if (arg.starts_with("-")) {
+      usage(argv[0]);
+    } else {
+      options.lexicons.emplace_back(arg);
+    }
+  }
+
+  if (options.lexicons.empty()) {
+    for (auto filename : {"en_1k.txt", "en_466k.txt", "zh_cn_406k.txt"}) {
+      options.lexicons.push_back(std::string(DATA_DIR) + filename);
+    }
+  }
+
+  return options;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  auto options = parse_options(argc, argv);
+
+  PerfCounters perf(options.counters);
+  for (size_t i = 0; options.counters && i < PerfCounters::N_COUNTERS; ++i) {
+    auto c = static_cast<PerfCounters::Counter>(i);
+    if (!perf.available(c)) {
+      fprintf(stderr, "counter %s unavailable: %s\n", PerfCounters::name(c),
+              perf.error(c).c_str());
+    }
+  }
+
+  if (!HugePageAllocator<char>::available()) {
+    fprintf(stderr, "transparent huge pages disabled, *_thp backends run on "
+                    "4 KB pages\n");
+  }
+
+  Reporter reporter(options.format);
+  Context ctx{options, perf, reporter};
+  for (auto &path : options.lexicons) {
+    auto words = load_lexicon(path.c_str());
+    if (words.empty()) {
+      fprintf(stderr, "%s: no words, skipped\n", path.c_str());
+      continue;
+    }
+
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    auto name = path.substr(path.find_last_of("/\\") + 1);
+    Dataset dataset(std::move(name), std::move(words), options);
+    run_all(dataset, ctx);
+  }
+
+  return 0;
+}
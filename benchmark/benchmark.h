@@ -0,0 +1,466 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "perf_counters.h"
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <trie_concepts.h>
+#include <vector>
+
+namespace xtrie {
+
+namespace bench {
+
+//! @brief Queries copied into one contiguous pool before timing
+//!
+//!     The timed loops only walk an array of string_views, so no allocation
+//!     or hash map iteration is measured together with the trie.
+class QuerySet {
+public:
+  QuerySet(std::string name, const std::vector<std::string> &queries)
+      : name_(std::move(name)) {
+    size_t total = 0;
+    for (auto &q : queries) {
+      total += q.size();
+    }
+
+    pool_.reserve(total);
+    for (auto &q : queries) {
+      pool_ += q;
+    }
+
+    size_t offset = 0;
+    queries_.reserve(queries.size());
+    for (auto &q : queries) {
+      queries_.emplace_back(pool_.data() + offset, q.size());
+      offset += q.size();
+    }
+  }
+
+  QuerySet(const QuerySet &) = delete;
+  QuerySet &operator=(const QuerySet &) = delete;
+
+  const std::string &name() const { return name_; }
+  const std::vector<std::string_view> &queries() const { return queries_; }
+
+private:
+  std::string name_;
+  std::string pool_;
+  std::vector<std::string_view> queries_;
+};
+
+struct Measurement {
+  std::string backend;
+  std::string dataset;
+  std::string query_set;
+
+  size_t n_queries = 0;
+  size_t n_found = 0;
+  size_t repetitions = 0;
+  size_t n_threads = 1;
+
+  // queries per second of all the threads over the repetitions
+  double qps_median = 0;
+  double qps_min = 0;
+  double qps_max = 0;
+
+  // nanoseconds per query, timer overhead subtracted
+  double latency_p50 = 0;
+  double latency_p99 = 0;
+
+  // hardware events per query in the throughput passes, NaN if unavailable
+  PerfCounters::values_type counters;
+
+  //! @brief Memory traffic of the median throughput pass in MB/s, NaN if
+  //! LLC misses are not counted
+  //!
+  //!     Every LLC read miss fills a 64-byte line from memory. Prefetches
+  //!     and write-backs are not counted, so this is a lower bound.
+  double bandwidth_mb_s() const {
+    return counters[PerfCounters::LLC_MISSES] * 64 * qps_median / 1e6;
+  }
+};
+
+template <IsTrie Trie> bool lookup(const Trie &trie, std::string_view q) {
+  auto res = trie.traverse(q);
+  return res.matched() && trie.has_value_at(res.state());
+}
+
+namespace details {
+using clock = std::chrono::steady_clock;
+
+static double elapsed_ns(clock::time_point a, clock::time_point b) {
+  return static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count());
+}
+
+//! fraction q of the sorted values
+static double percentile(std::vector<double> &values, double q) {
+  if (values.empty())
+    return 0;
+
+  auto nth = values.begin() + static_cast<size_t>(q * (values.size() - 1));
+  std::nth_element(values.begin(), nth, values.end());
+  return *nth;
+}
+
+//! median cost of reading the clock, subtracted from every latency sample
+static double timer_overhead() {
+  static const double overhead = [] {
+    std::vector<double> samples(10000);
+    for (auto &s : samples) {
+      auto t0 = clock::now();
+      auto t1 = clock::now();
+      s = elapsed_ns(t0, t1);
+    }
+    return percentile(samples, 0.5);
+  }();
+  return overhead;
+}
+
+//! keeps the results of lookups which are only timed alive
+static void consume(size_t v) {
+  [[maybe_unused]] static volatile size_t sink;
+  sink = v;
+}
+
+//! @brief Fill the statistics of res from the samples of its passes
+//!
+//!     res.counters holds the counts summed over the throughput passes.
+static void summarize(Measurement &res, std::vector<double> &qps,
+                      std::vector<double> &latencies) {
+  if (!qps.empty()) {
+    res.qps_min = *std::min_element(qps.begin(), qps.end());
+    res.qps_max = *std::max_element(qps.begin(), qps.end());
+    res.qps_median = percentile(qps, 0.5);
+  }
+
+  res.latency_p50 = percentile(latencies, 0.5);
+  res.latency_p99 = percentile(latencies, 0.99);
+
+  double n_lookups = static_cast<double>(res.n_queries * res.repetitions);
+  for (auto &c : res.counters) {
+    c = n_lookups > 0 ? c / n_lookups : std::nan("");
+  }
+}
+} // namespace details
+
+//! @brief Time f(q) for every query of qs, f returns the number of results
+//!
+//!     Each repetition runs an untimed-per-query pass over the whole set for
+//!     throughput, then a pass timing every query on its own for the
+//!     latency percentiles. One warm-up pass runs before all of them.
+//!
+//!     perf counts the throughput passes only, the clock reads of the
+//!     latency passes would dominate the instruction counts.
+template <typename F>
+Measurement measure_queries(const QuerySet &qs, size_t repetitions,
+                            PerfCounters &perf, F &&f) {
+  using namespace details;
+
+  auto &queries = qs.queries();
+
+  Measurement res;
+  res.query_set = qs.name();
+  res.n_queries = queries.size();
+  res.repetitions = repetitions;
+
+  for (auto q : queries) {
+    res.n_found += f(q);
+  }
+
+  double overhead = timer_overhead();
+
+  std::vector<double> qps;
+  std::vector<double> latencies;
+  latencies.reserve(queries.size() * repetitions);
+
+  res.counters.fill(0);
+
+  for (size_t rep = 0; rep < repetitions; ++rep) {
+    size_t found = 0;
+    perf.start();
+    auto t0 = clock::now();
+    for (auto q : queries) {
+      found += f(q);
+    }
+    auto t1 = clock::now();
+    auto counts = perf.stop();
+
+    for (size_t i = 0; i < counts.size(); ++i) {
+      res.counters[i] += counts[i]; // NaN sticks
+    }
+
+    if (found != res.n_found) {
+      fprintf(stderr, "%s: lookups are not deterministic\n",
+              res.query_set.c_str());
+    }
+
+    double ns = elapsed_ns(t0, t1);
+    qps.push_back(ns > 0 ? queries.size() * 1e9 / ns : 0);
+
+    for (auto q : queries) {
+      auto t2 = clock::now();
+      found += f(q);
+      auto t3 = clock::now();
+      latencies.push_back(std::max(0.0, elapsed_ns(t2, t3) - overhead));
+    }
+    consume(found);
+  }
+
+  summarize(res, qps, latencies);
+  return res;
+}
+
+//! @brief Time f(q) on one thread per query set, all of them at once
+//!
+//!     The threads share whatever f reads, e.g. one loaded trie, so f must
+//!     be safe to call concurrently. Every throughput pass starts on all the
+//!     threads together, its throughput is the queries of every thread over
+//!     the time from the first start to the last end. The latency passes
+//!     run concurrently too, their samples are merged into the percentiles.
+//!
+//!     Each thread counts its own hardware events, the sums are reported
+//!     per lookup.
+//!
+//! @param counters count hardware events if available
+template <typename F>
+Measurement measure_threads(std::span<const QuerySet *const> query_sets,
+                            size_t repetitions, bool counters, F &&f) {
+  using namespace details;
+
+  size_t n_threads = query_sets.size();
+
+  Measurement res;
+  res.query_set = n_threads > 0 ? query_sets[0]->name() : "";
+  res.repetitions = repetitions;
+  res.n_threads = n_threads;
+  for (auto *qs : query_sets) {
+    res.n_queries += qs->queries().size();
+  }
+
+  double overhead = timer_overhead();
+
+  // the threads meet before each pass
+  std::barrier sync(static_cast<std::ptrdiff_t>(n_threads));
+
+  struct Result {
+    size_t found = 0;
+    std::vector<double> latencies;
+    PerfCounters::values_type counts{};
+    // of the throughput passes, timed by the thread itself so a late
+    // wake-up of another thread can't shorten a pass
+    std::vector<clock::time_point> starts, ends;
+  };
+  std::vector<Result> results(n_threads);
+
+  auto work = [&](size_t t) {
+    PerfCounters perf(counters);
+    auto &queries = query_sets[t]->queries();
+    auto &r = results[t];
+
+    // warm-up
+    for (auto q : queries) {
+      r.found += f(q);
+    }
+    r.latencies.reserve(queries.size() * repetitions);
+
+    for (size_t rep = 0; rep < repetitions; ++rep) {
+      size_t found = 0;
+      sync.arrive_and_wait();
+      perf.start();
+      r.starts.push_back(clock::now());
+      for (auto q : queries) {
+        found += f(q);
+      }
+      r.ends.push_back(clock::now());
+      auto counts = perf.stop();
+
+      for (size_t i = 0; i < counts.size(); ++i) {
+        r.counts[i] += counts[i];
+      }
+
+      for (auto q : queries) {
+        auto t2 = clock::now();
+        found += f(q);
+        auto t3 = clock::now();
+        r.latencies.push_back(std::max(0.0, elapsed_ns(t2, t3) - overhead));
+      }
+      consume(found);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < n_threads; ++t) {
+    threads.emplace_back(work, t);
+  }
+
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  // a pass lasts from the first start to the last end
+  std::vector<double> qps;
+  for (size_t rep = 0; rep < repetitions; ++rep) {
+    auto t0 = results[0].starts[rep], t1 = results[0].ends[rep];
+    for (auto &r : results) {
+      t0 = std::min(t0, r.starts[rep]);
+      t1 = std::max(t1, r.ends[rep]);
+    }
+
+    double ns = elapsed_ns(t0, t1);
+    qps.push_back(ns > 0 ? res.n_queries * 1e9 / ns : 0);
+  }
+
+  std::vector<double> latencies;
+  res.counters.fill(0);
+  for (auto &r : results) {
+    res.n_found += r.found;
+    latencies.insert(latencies.end(), r.latencies.begin(),
+                     r.latencies.end());
+    for (size_t i = 0; i < r.counts.size(); ++i) {
+      res.counters[i] += r.counts[i]; // NaN sticks
+    }
+  }
+
+  summarize(res, qps, latencies);
+  return res;
+}
+
+//! @brief Time lookups of every query of qs in trie
+template <IsTrie Trie>
+Measurement measure(const Trie &trie, const QuerySet &qs, size_t repetitions,
+                    PerfCounters &perf) {
+  return measure_queries(qs, repetitions, perf, [&](std::string_view q) {
+    return static_cast<size_t>(lookup(trie, q));
+  });
+}
+
+enum class Format { Table, Csv, Json };
+
+//! @brief Print measurements as they come, in a human or machine format
+class Reporter {
+public:
+  explicit Reporter(Format format, FILE *out = stdout)
+      : format_(format), out_(out) {}
+
+  ~Reporter() {
+    if (format_ == Format::Json)
+      fprintf(out_, n_ == 0 ? "[]\n" : "\n]\n");
+  }
+
+  Reporter(const Reporter &) = delete;
+  Reporter &operator=(const Reporter &) = delete;
+
+  void report(const Measurement &m) {
+    switch (format_) {
+    case Format::Table:
+      if (n_ == 0) {
+        fprintf(out_,
+                "%-20s %-16s %-6s %3s %9s %9s %12s %12s %12s %8s %8s",
+                "backend", "dataset", "set", "thr", "queries", "found",
+                "qps med", "qps min", "qps max", "p50 ns", "p99 ns");
+        for (auto c : COUNTER_HEADERS) {
+          fprintf(out_, " %8s", c);
+        }
+        fprintf(out_, " %8s\n", "MB/s");
+      }
+      fprintf(out_,
+              "%-20s %-16s %-6s %3zu %9zu %9zu %12.0f %12.0f %12.0f %8.1f "
+              "%8.1f",
+              m.backend.c_str(), m.dataset.c_str(), m.query_set.c_str(),
+              m.n_threads, m.n_queries, m.n_found, m.qps_median, m.qps_min,
+              m.qps_max, m.latency_p50, m.latency_p99);
+      for (auto c : m.counters) {
+        if (std::isnan(c))
+          fprintf(out_, " %8s", "-");
+        else
+          fprintf(out_, " %8.2f", c);
+      }
+      if (std::isnan(m.bandwidth_mb_s()))
+        fprintf(out_, " %8s\n", "-");
+      else
+        fprintf(out_, " %8.1f\n", m.bandwidth_mb_s());
+      break;
+
+    case Format::Csv:
+      if (n_ == 0) {
+        fprintf(out_, "backend,dataset,query_set,n_threads,n_queries,"
+                      "n_found,repetitions,qps_median,qps_min,qps_max,"
+                      "latency_p50_ns,latency_p99_ns");
+        for (size_t i = 0; i < PerfCounters::N_COUNTERS; ++i) {
+          fprintf(out_, ",%s_per_lookup",
+                  PerfCounters::name(static_cast<PerfCounters::Counter>(i)));
+        }
+        fprintf(out_, ",bandwidth_mb_s\n");
+      }
+      fprintf(out_, "%s,%s,%s,%zu,%zu,%zu,%zu,%.0f,%.0f,%.0f,%.1f,%.1f",
+              m.backend.c_str(), m.dataset.c_str(), m.query_set.c_str(),
+              m.n_threads, m.n_queries, m.n_found, m.repetitions,
+              m.qps_median, m.qps_min, m.qps_max, m.latency_p50,
+              m.latency_p99);
+      for (auto c : m.counters) {
+        if (std::isnan(c))
+          fprintf(out_, ",");
+        else
+          fprintf(out_, ",%.4f", c);
+      }
+      if (std::isnan(m.bandwidth_mb_s()))
+        fprintf(out_, ",\n");
+      else
+        fprintf(out_, ",%.1f\n", m.bandwidth_mb_s());
+      break;
+
+    case Format::Json:
+      fprintf(out_, n_ == 0 ? "[\n" : ",\n");
+      fprintf(out_,
+              "  {\"backend\": \"%s\", \"dataset\": \"%s\", "
+              "\"query_set\": \"%s\", \"n_threads\": %zu, "
+              "\"n_queries\": %zu, \"n_found\": %zu, \"repetitions\": %zu, "
+              "\"qps_median\": %.0f, \"qps_min\": %.0f, \"qps_max\": %.0f, "
+              "\"latency_p50_ns\": %.1f, \"latency_p99_ns\": %.1f",
+              m.backend.c_str(), m.dataset.c_str(), m.query_set.c_str(),
+              m.n_threads, m.n_queries, m.n_found, m.repetitions,
+              m.qps_median, m.qps_min, m.qps_max, m.latency_p50,
+              m.latency_p99);
+      for (size_t i = 0; i < PerfCounters::N_COUNTERS; ++i) {
+        fprintf(out_, ", \"%s_per_lookup\": ",
+                PerfCounters::name(static_cast<PerfCounters::Counter>(i)));
+        if (std::isnan(m.counters[i]))
+          fprintf(out_, "null");
+        else
+          fprintf(out_, "%.4f", m.counters[i]);
+      }
+      if (std::isnan(m.bandwidth_mb_s()))
+        fprintf(out_, ", \"bandwidth_mb_s\": null}");
+      else
+        fprintf(out_, ", \"bandwidth_mb_s\": %.1f}", m.bandwidth_mb_s());
+      break;
+    }
+
+    fflush(out_);
+    ++n_;
+  }
+
+private:
+  static constexpr const char *COUNTER_HEADERS[PerfCounters::N_COUNTERS] = {
+      "cyc/q", "ins/q", "brmis/q", "L1Dmis/q", "LLCmis/q", "TLBmis/q"};
+
+  Format format_;
+  FILE *out_;
+  size_t n_ = 0;
+};
+
+} // namespace bench
+
+} // namespace xtrie
+
+#endif // BENCHMARK_H
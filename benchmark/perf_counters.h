@@ -0,0 +1,176 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace xtrie {
+
+namespace bench {
+
+//! @brief Hardware counters of the calling thread, read around a region
+//!
+//!     Every counter is opened on its own, so a counter the CPU, the kernel
+//!     or the sandbox doesn't offer is only marked unavailable and the rest
+//!     still count. Kernel-side events are excluded, which is what
+//!     perf_event_paranoid 2 allows for unprivileged users.
+//!
+//!     Counters the PMU multiplexes are scaled by enabled / running time.
+//!     Everything is unavailable on other OSes.
+class PerfCounters {
+public:
+  enum Counter {
+    CYCLES,
+    INSTRUCTIONS,
+    BRANCH_MISSES,
+    L1D_MISSES,
+    LLC_MISSES,
+    DTLB_MISSES,
+    N_COUNTERS
+  };
+
+  using values_type = std::array<double, N_COUNTERS>;
+
+  static const char *name(Counter c) {
+    constexpr const char *names[N_COUNTERS] = {
+        "cycles", "instructions", "branch_misses",
+        "l1d_misses", "llc_misses", "dtlb_misses"};
+    return names[c];
+  }
+
+  //! @param enabled opens nothing if false
+  explicit PerfCounters(bool enabled = true) {
+    fds_.fill(-1);
+    errors_.fill("disabled");
+
+#ifdef __linux__
+    if (!enabled)
+      return;
+
+    auto cache = [](uint64_t id, uint64_t op, uint64_t result) {
+      return id | (op << 8) | (result << 16);
+    };
+
+    const std::array<std::pair<uint32_t, uint64_t>, N_COUNTERS> events = {{
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_HW_CACHE,
+         cache(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ,
+               PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        {PERF_TYPE_HW_CACHE,
+         cache(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ,
+               PERF_COUNT_HW_CACHE_RESULT_MISS)},
+        {PERF_TYPE_HW_CACHE,
+         cache(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ,
+               PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    }};
+
+    for (size_t i = 0; i < N_COUNTERS; ++i) {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = events[i].first;
+      attr.config = events[i].second;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format =
+          PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      fds_[i] = static_cast<int>(
+          syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+      errors_[i] = fds_[i] < 0 ? std::strerror(errno) : "";
+    }
+#else
+    (void)enabled;
+    errors_.fill("not supported on this OS");
+#endif
+  }
+
+  ~PerfCounters() {
+#ifdef __linux__
+    for (int fd : fds_) {
+      if (fd >= 0)
+        close(fd);
+    }
+#endif
+  }
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  bool available(Counter c) const { return fds_[c] >= 0; }
+
+  bool any_available() const {
+    for (int fd : fds_) {
+      if (fd >= 0)
+        return true;
+    }
+    return false;
+  }
+
+  //! why the counter is unavailable
+  const std::string &error(Counter c) const { return errors_[c]; }
+
+  void start() {
+#ifdef __linux__
+    for (int fd : fds_) {
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+#endif
+  }
+
+  //! @return the counts since start(), NaN if unavailable
+  values_type stop() {
+    values_type res;
+    res.fill(std::numeric_limits<double>::quiet_NaN());
+
+#ifdef __linux__
+    for (int fd : fds_) {
+      if (fd >= 0)
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    for (size_t i = 0; i < N_COUNTERS; ++i) {
+      uint64_t buf[3]; // value, time enabled, time running
+      if (fds_[i] < 0 || read(fds_[i], buf, sizeof(buf)) != sizeof(buf))
+        continue;
+
+      // never scheduled on the PMU, the count means nothing
+      if (buf[2] == 0)
+        continue;
+
+      res[i] = static_cast<double>(buf[0]) * static_cast<double>(buf[1]) /
+               static_cast<double>(buf[2]);
+    }
+#endif
+
+    return res;
+  }
+
+private:
+  std::array<int, N_COUNTERS> fds_;
+  std::array<std::string, N_COUNTERS> errors_;
+};
+
+} // namespace bench
+
+} // namespace xtrie
+
+#endif // PERF_COUNTERS_H
@@ -0,0 +1,74 @@
+// Replacements of the global allocation functions that feed the heap fields
+// of MemInfo. Linked only into the executables whose target links
+// count_allocations, which also defines COUNT_ALLOCATIONS for them.
+// Over-aligned new isn't replaced and isn't counted.
+
+#include "profile.h"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+// keeps the block size in front of the block, aligned like malloc
+constexpr size_t HEAP_HEADER_SIZE = alignof(std::max_align_t);
+
+void *counted_alloc(size_t n) {
+  auto *p = static_cast<char *>(malloc(n + HEAP_HEADER_SIZE));
+  if (p == nullptr)
+    return nullptr;
+
+  *reinterpret_cast<size_t *>(p) = n;
+
+  auto &c = profile_details::heap_counters;
+  size_t bytes = c.bytes.fetch_add(n, std::memory_order_relaxed) + n;
+  size_t peak = c.peak_bytes.load(std::memory_order_relaxed);
+  while (bytes > peak && !c.peak_bytes.compare_exchange_weak(
+                             peak, bytes, std::memory_order_relaxed)) {
+  }
+  c.allocations.fetch_add(1, std::memory_order_relaxed);
+
+  return p + HEAP_HEADER_SIZE;
+}
+
+void counted_free(void *ptr) {
+  if (ptr == nullptr)
+    return;
+
+  auto *p = static_cast<char *>(ptr) - HEAP_HEADER_SIZE;
+  profile_details::heap_counters.bytes.fetch_sub(
+      *reinterpret_cast<size_t *>(p), std::memory_order_relaxed);
+  free(p);
+}
+} // namespace
+
+void *operator new(size_t n) {
+  if (void *p = counted_alloc(n))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](size_t n) { return operator new(n); }
+
+void *operator new(size_t n, const std::nothrow_t &) noexcept {
+  return counted_alloc(n);
+}
+
+void *operator new[](size_t n, const std::nothrow_t &) noexcept {
+  return counted_alloc(n);
+}
+
+void operator delete(void *p) noexcept { counted_free(p); }
+
+void operator delete[](void *p) noexcept { counted_free(p); }
+
+void operator delete(void *p, size_t) noexcept { counted_free(p); }
+
+void operator delete[](void *p, size_t) noexcept { counted_free(p); }
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  counted_free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  counted_free(p);
+}
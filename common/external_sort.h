@@ -0,0 +1,222 @@
+#ifndef EXTERNAL_SORT_H
+#define EXTERNAL_SORT_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <queue>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace xtrie {
+
+namespace details {
+//! a file name under dir no other instance, thread or process picks
+inline std::filesystem::path unique_temp_path(const std::filesystem::path &dir,
+                                              const char *prefix) {
+  static std::atomic<uint64_t> counter{0};
+  static const uint64_t seed = std::random_device{}();
+
+  return dir / (std::string(prefix) + std::to_string(seed) + "_" +
+                std::to_string(counter.fetch_add(1)));
+}
+} // namespace details
+
+//! @brief Sorts (key, value) pairs which don't fit in memory
+//!
+//!     Pairs are buffered until the buffer takes memory_budget bytes, then
+//!     sorted and spilled as a run file. merge() sorts the rest and merges
+//!     every run with a k-way merge, so the memory taken is the budget plus
+//!     one read buffer per run, however many keys there are.
+//!
+//!     Keys come out in byte order without duplicates, which is what the
+//!     streaming DAWG minimizer behind the builders needs. A duplicated key
+//!     keeps the value it was added with first.
+template <typename T = int> class ExternalSorter {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+  explicit ExternalSorter(
+      size_t memory_budget = 64 << 20,
+      std::filesystem::path dir = std::filesystem::temp_directory_path())
+      : memory_budget_(memory_budget), dir_(std::move(dir)) {}
+
+  ~ExternalSorter() {
+    std::error_code error;
+    for (auto &path : runs_) {
+      std::filesystem::remove(path, error);
+    }
+  }
+
+  ExternalSorter(const ExternalSorter &) = delete;
+  ExternalSorter &operator=(const ExternalSorter &) = delete;
+
+  void add(std::string_view key, T value) {
+    entries_.push_back({pool_.size(), static_cast<uint32_t>(key.size()),
+                        entries_.size(), value});
+    pool_.append(key);
+
+    if (pool_.size() + entries_.size() * sizeof(Entry) >= memory_budget_)
+      spill();
+  }
+
+  //! runs spilled so far
+  size_t run_count() const { return runs_.size(); }
+
+  //! @brief Call f(key, value) for every key in order, once
+  //!
+  //!     The sorter is empty afterwards. Nothing is written to disk if
+  //!     everything fitted in the budget.
+  template <typename F> void merge(F &&f) {
+    if (runs_.empty()) {
+      sort_entries();
+      for (size_t i = 0; i < entries_.size(); ++i) {
+        auto key = key_of(entries_[i]);
+        if (i == 0 || key != key_of(entries_[i - 1]))
+          f(key, entries_[i].value);
+      }
+      clear_buffer();
+      return;
+    }
+
+    if (!entries_.empty())
+      spill();
+
+    std::vector<RunReader> readers;
+    readers.reserve(runs_.size());
+    for (auto &path : runs_) {
+      readers.emplace_back(path);
+    }
+
+    // the first run wins among equal keys, its pairs were added first
+    auto greater = [&](size_t a, size_t b) {
+      int c = readers[a].key.compare(readers[b].key);
+      return c != 0 ? c > 0 : a > b;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(
+        greater);
+    for (size_t i = 0; i < readers.size(); ++i) {
+      if (readers[i].next())
+        heap.push(i);
+    }
+
+    std::string prev;
+    bool first = true;
+    while (!heap.empty()) {
+      size_t i = heap.top();
+      heap.pop();
+
+      auto &reader = readers[i];
+      if (first || reader.key != prev) {
+        f(std::string_view(reader.key), reader.value);
+        prev = reader.key;
+        first = false;
+      }
+
+      if (reader.next())
+        heap.push(i);
+    }
+
+    readers.clear();
+    std::error_code error;
+    for (auto &path : runs_) {
+      std::filesystem::remove(path, error);
+    }
+    runs_.clear();
+  }
+
+private:
+  struct Entry {
+    size_t offset; // in pool_
+    uint32_t size;
+    size_t order; // of add, keeps equal keys in order
+    T value;
+  };
+
+  struct RunReader {
+    explicit RunReader(const std::filesystem::path &path)
+        : is(path, std::ios::binary) {}
+
+    bool next() {
+      uint32_t size;
+      if (!is.read(reinterpret_cast<char *>(&size), sizeof(size)))
+        return false;
+
+      key.resize(size);
+      is.read(key.data(), size);
+      is.read(reinterpret_cast<char *>(&value), sizeof(T));
+      return static_cast<bool>(is);
+    }
+
+    std::ifstream is;
+    std::string key;
+    T value;
+  };
+
+  std::string_view key_of(const Entry &e) const {
+    return std::string_view(pool_).substr(e.offset, e.size);
+  }
+
+  void sort_entries() {
+    std::sort(entries_.begin(), entries_.end(),
+              [&](const Entry &a, const Entry &b) {
+                int c = key_of(a).compare(key_of(b));
+                return c != 0 ? c < 0 : a.order < b.order;
+              });
+  }
+
+  void clear_buffer() {
+    // give the memory back, the budget is about what is held
+    std::string().swap(pool_);
+    std::vector<Entry>().swap(entries_);
+  }
+
+  void spill() {
+    sort_entries();
+
+    auto path = details::unique_temp_path(dir_, "xtrie_run_");
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    if (!os) {
+      throw std::filesystem::filesystem_error(
+          "cannot create run file", path,
+          std::make_error_code(std::errc::io_error));
+    }
+    runs_.push_back(path);
+
+    for (size_t i = 0; i < entries_.size(); ++i) {
+      auto key = key_of(entries_[i]);
+      if (i > 0 && key == key_of(entries_[i - 1]))
+        continue;
+
+      uint32_t size = static_cast<uint32_t>(key.size());
+      os.write(reinterpret_cast<const char *>(&size), sizeof(size));
+      os.write(key.data(), size);
+      os.write(reinterpret_cast<const char *>(&entries_[i].value), sizeof(T));
+    }
+
+    if (!os) {
+      throw std::filesystem::filesystem_error(
+          "cannot write run file", path,
+          std::make_error_code(std::errc::io_error));
+    }
+
+    clear_buffer();
+  }
+
+  size_t memory_budget_;
+  std::filesystem::path dir_;
+
+  std::string pool_;
+  std::vector<Entry> entries_;
+  std::vector<std::filesystem::path> runs_;
+};
+
+} // namespace xtrie
+
+#endif // EXTERNAL_SORT_H
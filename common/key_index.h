@@ -0,0 +1,129 @@
+#ifndef KEY_INDEX_H
+#define KEY_INDEX_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace xtrie {
+
+//! @brief Parent of every state and state of every key of a trie, to get
+//! keys back from states
+//!
+//!     A double array unit only stores its label in check. Its parent is the
+//!     state whose base plus the label leads to it, which can't be found
+//!     without a scan, so the index keeps it: 4 bytes per unit, plus 4 per
+//!     key for the states in key order. Tries build it on demand after
+//!     loading, the serialized format doesn't change.
+//!
+//!     The ordinal of a key is its rank in key order, a dense id in
+//!     [0, size()).
+//!
+//!     Label functions are called as label(state) and return the char of
+//!     the transition leading to state, e.g. through a reverse charmap.
+class KeyIndex {
+public:
+  static constexpr uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+
+  //! @brief Index the states reachable from root
+  //!
+  //!     The trie needs for_each_child(state, g), g called as g(char, child
+  //!     state) in char order, and has_value_at(state).
+  template <typename Trie>
+  void build(const Trie &trie, size_t n_states, uint32_t root = 0) {
+    root_ = root;
+    parents_.assign(n_states, NO_PARENT);
+    states_.clear();
+
+    // preorder with children in char order is key order, the stack keeps
+    // long keys off the call stack
+    std::vector<uint32_t> stack{root};
+    std::vector<uint32_t> children;
+    while (!stack.empty()) {
+      uint32_t state = stack.back();
+      stack.pop_back();
+
+      if (trie.has_value_at(state))
+        states_.push_back(state);
+
+      children.clear();
+      trie.for_each_child(state, [&](char, uint32_t child) {
+        parents_[child] = state;
+        children.push_back(child);
+      });
+      stack.insert(stack.end(), children.rbegin(), children.rend());
+    }
+  }
+
+  bool built() const { return !parents_.empty(); }
+
+  //! number of keys
+  size_t size() const { return states_.size(); }
+
+  //! NO_PARENT for the root and the units out of the trie
+  uint32_t parent(uint32_t state) const { return parents_[state]; }
+
+  //! state of the key of ordinal
+  uint32_t state(size_t ordinal) const { return states_[ordinal]; }
+
+  //! @brief Number of transitions from the root to state
+  size_t depth(uint32_t state) const {
+    size_t n = 0;
+    for (uint32_t p = state; p != root_; p = parents_[p]) {
+      assert(parents_[p] != NO_PARENT);
+      ++n;
+    }
+    return n;
+  }
+
+  //! @brief Write the key leading to state into buf, O(depth)
+  //!
+  //! @return length of the key, nothing is written if it is more than size
+  template <typename Label>
+  size_t restore(uint32_t state, Label &&label, char *buf,
+                 size_t size) const {
+    size_t n = depth(state);
+    if (n > size)
+      return n;
+
+    size_t i = n;
+    for (uint32_t p = state; p != root_; p = parents_[p]) {
+      buf[--i] = label(p);
+    }
+    return n;
+  }
+
+  template <typename Label>
+  void restore(uint32_t state, Label &&label, std::string &key) const {
+    key.resize(depth(state));
+    restore(state, label, key.data(), key.size());
+  }
+
+  //! @brief Ordinal of the key of a state with a value, by binary search
+  //! over the restored keys, O(depth log size())
+  template <typename Label>
+  size_t ordinal(uint32_t state, Label &&label) const {
+    std::string key, probe;
+    restore(state, label, key);
+
+    auto it = std::lower_bound(states_.begin(), states_.end(), key,
+                               [&](uint32_t s, const std::string &k) {
+                                 restore(s, label, probe);
+                                 return probe < k;
+                               });
+    assert(it != states_.end() && *it == state);
+    return static_cast<size_t>(it - states_.begin());
+  }
+
+private:
+  uint32_t root_ = 0;
+  std::vector<uint32_t> parents_;
+  std::vector<uint32_t> states_; // in key order
+};
+
+} // namespace xtrie
+
+#endif // KEY_INDEX_H
@@ -0,0 +1,196 @@
+#ifndef KEY_RANGE_H
+#define KEY_RANGE_H
+
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace xtrie {
+
+//! @brief The keys of a trie in [lo, hi), in key order
+//!
+//!     Keys compare bytewise like std::string. The iterator is lazy: it
+//!     seeks lo by descending along it once, then goes on with a depth
+//!     first walk whose frames are kept explicitly, and stops at the first
+//!     key not less than hi, so a range costs its size plus the depth of
+//!     lo.
+//!
+//!     The trie needs for_each_child(state, g), g called as g(char, child
+//!     state) in char order, besides traverse(prefix) and
+//!     has_value_at(state).
+template <typename Trie> class KeyRange {
+public:
+  using state_type =
+      std::remove_cvref_t<decltype(std::declval<const Trie &>()
+                                       .traverse(std::string_view())
+                                       .state())>;
+
+  struct Entry {
+    std::string_view key; // valid until the iterator is advanced
+    state_type state;
+  };
+
+  class iterator {
+    friend class KeyRange;
+
+  public:
+    using value_type = Entry;
+    using difference_type = std::ptrdiff_t;
+
+    iterator(iterator &&) = default;
+    iterator &operator=(iterator &&) = default;
+
+    // the key is pointed at here, a moved iterator has moved its key_
+    const Entry &operator*() const {
+      entry_.key = key_;
+      return entry_;
+    }
+    const Entry *operator->() const { return &**this; }
+
+    iterator &operator++() {
+      advance();
+      return *this;
+    }
+
+    void operator++(int) { advance(); }
+
+    bool operator==(std::default_sentinel_t) const { return depth_ < 0; }
+
+  private:
+    struct Frame {
+      state_type state;
+      bool entered = false;
+      size_t next_child = 0;
+      std::vector<std::pair<char, state_type>> children;
+    };
+
+    iterator(const Trie &trie, std::string_view lo, std::string_view hi,
+             bool bounded)
+        : trie_(&trie), hi_(hi), bounded_(bounded) {
+      frames_.emplace_back();
+      frames_[0].state = trie.traverse(std::string_view()).state();
+      depth_ = 0;
+      seek(lo);
+      advance();
+    }
+
+    void enter(Frame &frame) {
+      frame.entered = true;
+      frame.next_child = 0;
+      frame.children.clear();
+      trie_->for_each_child(frame.state, [&](char ch, state_type child) {
+        frame.children.push_back({ch, child});
+      });
+    }
+
+    void push(state_type child, char ch) {
+      key_.push_back(ch);
+      ++depth_;
+      // frames are kept, so their children keep their capacity
+      if (frames_.size() == static_cast<size_t>(depth_))
+        frames_.emplace_back();
+      auto &next = frames_[depth_];
+      next.state = child;
+      next.entered = false;
+    }
+
+    //! @brief Leave the frames as if the walk had just passed every key
+    //! less than lo
+    void seek(std::string_view lo) {
+      for (char lo_ch : lo) {
+        auto &frame = frames_[depth_];
+        // the keys of the frame itself and of its lesser children are
+        // less than lo
+        enter(frame);
+        auto &children = frame.children;
+        while (frame.next_child < children.size() &&
+               static_cast<unsigned char>(children[frame.next_child].first) <
+                   static_cast<unsigned char>(lo_ch)) {
+          ++frame.next_child;
+        }
+
+        if (frame.next_child == children.size() ||
+            children[frame.next_child].first != lo_ch)
+          return;
+
+        push(children[frame.next_child++].second, lo_ch);
+      }
+    }
+
+    void advance() {
+      while (depth_ >= 0) {
+        auto &frame = frames_[depth_];
+
+        if (!frame.entered) {
+          enter(frame);
+          if (trie_->has_value_at(frame.state)) {
+            if (bounded_ && std::string_view(key_) >= hi_) {
+              depth_ = -1;
+              return;
+            }
+            entry_.state = frame.state;
+            return;
+          }
+        }
+
+        if (frame.next_child < frame.children.size()) {
+          auto [ch, child] = frame.children[frame.next_child++];
+          push(child, ch);
+          continue;
+        }
+
+        if (depth_ > 0)
+          key_.pop_back();
+        --depth_;
+      }
+    }
+
+    const Trie *trie_;
+    std::string hi_;
+    bool bounded_;
+
+    std::vector<Frame> frames_;
+    std::ptrdiff_t depth_ = -1; // -1 once done
+    std::string key_;
+    mutable Entry entry_;
+  };
+
+  //! no upper bound
+  KeyRange(const Trie &trie, std::string_view lo)
+      : trie_(trie), lo_(lo), bounded_(false) {}
+
+  KeyRange(const Trie &trie, std::string_view lo, std::string_view hi)
+      : trie_(trie), lo_(lo), hi_(hi), bounded_(true) {}
+
+  iterator begin() const { return iterator(trie_, lo_, hi_, bounded_); }
+  std::default_sentinel_t end() const { return {}; }
+
+private:
+  const Trie &trie_;
+  std::string lo_;
+  std::string hi_;
+  bool bounded_;
+};
+
+//! @brief The keys of trie in [lo, hi), see KeyRange
+template <typename Trie>
+KeyRange<Trie> key_range(const Trie &trie, std::string_view lo,
+                         std::string_view hi) {
+  return KeyRange<Trie>(trie, lo, hi);
+}
+
+//! @brief Iterator to the first key of trie not less than key, to
+//! std::default_sentinel at the end
+template <typename Trie>
+typename KeyRange<Trie>::iterator key_lower_bound(const Trie &trie,
+                                                  std::string_view key) {
+  return KeyRange<Trie>(trie, key).begin();
+}
+
+} // namespace xtrie
+
+#endif // KEY_RANGE_H
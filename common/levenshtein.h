@@ -0,0 +1,212 @@
+#ifndef LEVENSHTEIN_H
+#define LEVENSHTEIN_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace xtrie {
+
+//! @brief Levenshtein automaton of a query, accepting the strings within
+//! max_edits insertions, deletions or substitutions of it
+//!
+//!     A state is a row of the edit distance table: the distances between
+//!     the input read so far and every prefix of the query. Only the
+//!     diagonal band of width 2 * max_edits + 1 is computed, the cells out
+//!     of it are more than max_edits anyway, so a step costs O(max_edits).
+//!     Distances are capped at max_edits + 1.
+//!
+//!     Edits are counted on bytes.
+class LevenshteinAutomaton {
+public:
+  LevenshteinAutomaton(std::string_view query, uint32_t max_edits)
+      : query_(query), max_edits_(max_edits) {}
+
+  uint32_t max_edits() const { return max_edits_; }
+
+  //! number of cells of a state
+  size_t row_size() const { return query_.size() + 1; }
+
+  //! the state before any input
+  void start(uint32_t *row) const {
+    for (size_t i = 0; i < row_size(); ++i) {
+      row[i] = std::min<size_t>(i, dead());
+    }
+  }
+
+  //! @brief The state after reading ch from row, which read depth bytes
+  //!
+  //! @return false if no string starting with the input can match any more
+  bool step(const uint32_t *row, uint32_t *next, size_t depth,
+            char ch) const {
+    size_t n = query_.size();
+    size_t d = depth + 1;
+
+    size_t lo = d > max_edits_ ? d - max_edits_ : 0;
+    size_t hi = std::min(n, d + max_edits_);
+    if (lo > n)
+      return false;
+
+    // the borders of the band are read by the next step, the last cell by
+    // distance()
+    if (lo > 0)
+      next[lo - 1] = dead();
+    if (hi < n) {
+      next[hi + 1] = dead();
+      next[n] = dead();
+    }
+
+    uint32_t best = dead();
+    for (size_t i = lo; i <= hi; ++i) {
+      uint32_t v = row[i] + 1; // ch inserted
+      if (i > 0) {
+        v = std::min(v, next[i - 1] + 1); // query[i - 1] deleted
+        v = std::min(v, row[i - 1] + (query_[i - 1] != ch ? 1u : 0u));
+      }
+      next[i] = std::min(v, dead());
+      best = std::min(best, next[i]);
+    }
+
+    return best <= max_edits_;
+  }
+
+  //! @brief The only chars the input can go on with if no edit is left
+  //!
+  //!     Every cell of the band reached max_edits, so only the query chars
+  //!     following those cells keep the automaton alive.
+  //!
+  //! @param chars sorted and without duplicates
+  //! @return false if edits are left, any char may follow then
+  bool exact_chars(const uint32_t *row, size_t depth,
+                   std::string &chars) const {
+    size_t n = query_.size();
+    size_t lo = depth > max_edits_ ? depth - max_edits_ : 0;
+    size_t hi = std::min(n, depth + max_edits_);
+
+    chars.clear();
+    for (size_t i = lo; i <= hi; ++i) {
+      if (row[i] < max_edits_)
+        return false;
+      if (row[i] == max_edits_ && i < n)
+        chars.push_back(query_[i]);
+    }
+
+    std::sort(chars.begin(), chars.end(), [](char a, char b) {
+      return static_cast<uint8_t>(a) < static_cast<uint8_t>(b);
+    });
+    chars.erase(std::unique(chars.begin(), chars.end()), chars.end());
+    return true;
+  }
+
+  //! distance of the input to the query, more than max_edits if too far
+  uint32_t distance(const uint32_t *row) const { return row[query_.size()]; }
+
+  bool accepts(const uint32_t *row) const {
+    return distance(row) <= max_edits_;
+  }
+
+  //! @brief Distance of s to the query, more than max_edits if too far
+  //!
+  //!     Runs the automaton over s, e.g. to check every key of a lexicon.
+  uint32_t distance_to(std::string_view s) const {
+    std::vector<uint32_t> a(row_size()), b(row_size());
+    start(a.data());
+
+    for (size_t i = 0; i < s.size(); ++i) {
+      if (!step(a.data(), b.data(), i, s[i]))
+        return dead();
+      a.swap(b);
+    }
+    return distance(a.data());
+  }
+
+private:
+  uint32_t dead() const { return max_edits_ + 1; }
+
+  std::string_view query_;
+  uint32_t max_edits_;
+};
+
+namespace details {
+template <typename Trie, typename State, typename F> class LevenshteinWalk {
+public:
+  LevenshteinWalk(const LevenshteinAutomaton &automaton, const Trie &trie,
+                  F &f)
+      : automaton_(automaton), trie_(trie), f_(f),
+        rows_(automaton.row_size()) {}
+
+  void run(State root) {
+    automaton_.start(rows_.data());
+    visit(root, 0);
+  }
+
+private:
+  void visit(State state, size_t depth) {
+    size_t w = automaton_.row_size();
+
+    uint32_t d = automaton_.distance(rows_.data() + depth * w);
+    if (d <= automaton_.max_edits() && trie_.has_value_at(state))
+      f_(std::string_view(key_), state, d);
+
+    if (rows_.size() < (depth + 2) * w)
+      rows_.resize((depth + 2) * w);
+
+    auto follow = [&](char ch, State child) {
+      // deeper visits may grow rows_
+      auto *row = rows_.data() + depth * w;
+      if (!automaton_.step(row, row + w, depth, ch))
+        return;
+
+      key_.push_back(ch);
+      visit(child, depth + 1);
+      key_.pop_back();
+    };
+
+    // no edit left, the query says which transitions to take instead of
+    // trying every label
+    std::string chars;
+    if (automaton_.exact_chars(rows_.data() + depth * w, depth, chars)) {
+      for (char ch : chars) {
+        auto res = trie_.traverse(std::string_view(&ch, 1), state);
+        if (res.matched())
+          follow(ch, res.state());
+      }
+      return;
+    }
+
+    trie_.for_each_child(state, follow);
+  }
+
+  const LevenshteinAutomaton &automaton_;
+  const Trie &trie_;
+  F &f_;
+
+  std::vector<uint32_t> rows_; // the state of every depth of the path
+  std::string key_;
+};
+} // namespace details
+
+//! @brief Walk a trie and the automaton in lockstep, calling f for every key
+//! within max_edits of the query
+//!
+//!     A branch is left as soon as its automaton state is dead, so only the
+//!     states reachable within max_edits are visited.
+//!
+//!     The trie needs for_each_child(state, g), g called as g(char, child
+//!     state), besides traverse(prefix, state) and has_value_at(state).
+//!
+//! @param f called as f(key, state, distance), key is valid during the call
+template <typename Trie, typename State, typename F>
+void levenshtein_walk(const LevenshteinAutomaton &automaton, const Trie &trie,
+                      State root, F &&f) {
+  details::LevenshteinWalk<Trie, State, std::remove_reference_t<F>>(
+      automaton, trie, f)
+      .run(root);
+}
+
+} // namespace xtrie
+
+#endif // LEVENSHTEIN_H
@@ -2,8 +2,14 @@
 #define LOADER_H
 
 #include <algorithm>
+#include <charconv>
 #include <fstream>
+#include <mio/mio.hpp>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
 static std::vector<std::string> load_lexicon(const char *path) {
@@ -23,4 +29,120 @@ static std::vector<std::string> load_lexicon(const char *path) {
   return res;
 }
 
+//! @brief Lexicon file mapped into memory, keys point into the mapping
+//!
+//!     Lines are "key" or "key\tvalue", like for load_lexicon. The mapping is
+//!     cut into one chunk per thread at line boundaries and the chunks are
+//!     parsed in parallel, keys keep the order of the file.
+//!
+//!     The value column is parsed into T with std::from_chars, lines without
+//!     a value or with one that doesn't parse get default_value. A trailing
+//!     '\r' is not part of the line.
+template <typename T = int> class MappedLexicon {
+public:
+  MappedLexicon(const char *path, T default_value,
+                unsigned n_threads = std::thread::hardware_concurrency()) {
+    std::error_code error;
+    map_.map(path, error);
+    if (error || map_.size() == 0)
+      return; // no words, like load_lexicon
+
+    std::string_view text(map_.data(), map_.size());
+
+    n_threads = std::max(1u, n_threads);
+    n_threads = static_cast<unsigned>(
+        std::min<size_t>(n_threads, text.size() / MIN_CHUNK_SIZE + 1));
+
+    // chunk i is [bounds[i], bounds[i + 1]), each starts a line
+    std::vector<size_t> bounds(n_threads + 1, text.size());
+    bounds[0] = 0;
+    for (unsigned i = 1; i < n_threads; ++i) {
+      size_t nl = text.find('\n', std::max(bounds[i - 1],
+                                           text.size() / n_threads * i));
+      bounds[i] = nl == std::string_view::npos ? text.size() : nl + 1;
+    }
+
+    std::vector<Chunk> chunks(n_threads);
+    auto parse = [&](unsigned i) {
+      parse_chunk(text.substr(bounds[i], bounds[i + 1] - bounds[i]),
+                  default_value, chunks[i]);
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < n_threads; ++i) {
+      threads.emplace_back(parse, i);
+    }
+    parse(0);
+    for (auto &t : threads) {
+      t.join();
+    }
+
+    size_t n = 0;
+    for (auto &c : chunks) {
+      n += c.keys.size();
+    }
+
+    keys_.reserve(n);
+    values_.reserve(n);
+    for (auto &c : chunks) {
+      keys_.insert(keys_.end(), c.keys.begin(), c.keys.end());
+      values_.insert(values_.end(), c.values.begin(), c.values.end());
+    }
+  }
+
+  MappedLexicon(const MappedLexicon &) = delete;
+  MappedLexicon &operator=(const MappedLexicon &) = delete;
+
+  size_t size() const { return keys_.size(); }
+  bool empty() const { return keys_.empty(); }
+
+  //! valid as long as the lexicon
+  const std::vector<std::string_view> &keys() const { return keys_; }
+  const std::vector<T> &values() const { return values_; }
+
+private:
+  //! below this, splitting costs more than it saves
+  static constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+
+  struct Chunk {
+    std::vector<std::string_view> keys;
+    std::vector<T> values;
+  };
+
+  static void parse_chunk(std::string_view text, T default_value,
+                          Chunk &chunk) {
+    while (!text.empty()) {
+      size_t nl = text.find('\n');
+      auto line = text.substr(0, nl);
+      text.remove_prefix(nl == std::string_view::npos ? text.size() : nl + 1);
+
+      if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+
+      T value = default_value;
+
+      auto tab_i = line.find('\t');
+      if (tab_i != std::string_view::npos) {
+        auto column = line.substr(tab_i + 1);
+        line = line.substr(0, tab_i);
+
+        if constexpr (std::is_arithmetic_v<T>) {
+          T parsed;
+          auto [end, ec] = std::from_chars(
+              column.data(), column.data() + column.size(), parsed);
+          if (ec == std::errc())
+            value = parsed;
+        }
+      }
+
+      chunk.keys.push_back(line);
+      chunk.values.push_back(value);
+    }
+  }
+
+  mio::mmap_source map_;
+  std::vector<std::string_view> keys_;
+  std::vector<T> values_;
+};
+
 #endif // LOADER_H
\ No newline at end of file
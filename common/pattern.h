@@ -0,0 +1,519 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace xtrie {
+
+//! @brief DFA of a wildcard or regex pattern, matching whole keys
+//!
+//!     Regexes take literals, '.', classes like [a-z] or [^0-9], groups,
+//!     '|' and the '*', '+' and '?' quantifiers, '\' escapes the next char.
+//!     Globs take '?' for one char and '*' for any chars. A char is a byte.
+//!
+//!     States from which no key can be accepted any more are merged into
+//!     DEAD, so a walk stops on them at once.
+class PatternDfa {
+public:
+  static constexpr uint32_t DEAD = UINT32_MAX;
+
+  //! @return nullopt if the regex is malformed or needs more than
+  //! max_states states
+  static std::optional<PatternDfa> regex(std::string_view pattern,
+                                         size_t max_states = 4096) {
+    Nfa nfa;
+    size_t pos = 0;
+    auto fragment = nfa.parse_alt(pattern, pos);
+    if (!fragment || pos != pattern.size())
+      return std::nullopt;
+
+    PatternDfa res;
+    if (!res.build(nfa, *fragment, max_states))
+      return std::nullopt;
+    return res;
+  }
+
+  //! @brief DFA of a glob, see regex
+  //!
+  //!     A '*' followed by n '?' takes 2^n subsets of positions, so a glob
+  //!     has the same bound on its states as a regex.
+  //!
+  //! @return nullopt if the glob needs more than max_states states
+  static std::optional<PatternDfa> glob(std::string_view pattern,
+                                        size_t max_states = 4096) {
+    std::string re;
+    for (char ch : pattern) {
+      if (ch == '?') {
+        re += '.';
+      } else if (ch == '*') {
+        re += ".*";
+      } else {
+        re += '\\';
+        re += ch;
+      }
+    }
+    return regex(re, max_states);
+  }
+
+  uint32_t start() const { return accept_.empty() ? DEAD : 0; }
+
+  uint32_t next(uint32_t state, char ch) const {
+    return trans_[state][static_cast<uint8_t>(ch)];
+  }
+
+  bool accepting(uint32_t state) const { return accept_[state]; }
+
+  //! the chars leading out of state to a state other than DEAD, sorted
+  const std::string &live_chars(uint32_t state) const {
+    return live_chars_[state];
+  }
+
+  size_t size() const { return trans_.size(); }
+
+  bool matches(std::string_view s) const {
+    uint32_t state = start();
+    for (size_t i = 0; state != DEAD && i < s.size(); ++i) {
+      state = next(state, s[i]);
+    }
+    return state != DEAD && accepting(state);
+  }
+
+private:
+  //! Thompson NFA, a state has a char set edge or up to 2 epsilon edges
+  struct Nfa {
+    struct State {
+      std::bitset<256> chars;
+      int next = -1; // target of the chars
+      int eps[2] = {-1, -1};
+    };
+
+    struct Fragment {
+      int start;
+      int end; // no edge yet
+    };
+
+    std::vector<State> states;
+
+    int add() {
+      states.emplace_back();
+      return static_cast<int>(states.size() - 1);
+    }
+
+    void link(int from, int to) {
+      auto &eps = states[from].eps;
+      (eps[0] < 0 ? eps[0] : eps[1]) = to;
+    }
+
+    std::optional<Fragment> parse_alt(std::string_view p, size_t &pos) {
+      auto left = parse_concat(p, pos);
+      while (left && pos < p.size() && p[pos] == '|') {
+        ++pos;
+        auto right = parse_concat(p, pos);
+        if (!right)
+          return std::nullopt;
+
+        int s = add(), e = add();
+        link(s, left->start);
+        link(s, right->start);
+        link(left->end, e);
+        link(right->end, e);
+        left = Fragment{s, e};
+      }
+      return left;
+    }
+
+    std::optional<Fragment> parse_concat(std::string_view p, size_t &pos) {
+      int s = add();
+      Fragment res{s, s};
+      while (pos < p.size() && p[pos] != '|' && p[pos] != ')') {
+        auto f = parse_repeat(p, pos);
+        if (!f)
+          return std::nullopt;
+        link(res.end, f->start);
+        res.end = f->end;
+      }
+      return res;
+    }
+
+    std::optional<Fragment> parse_repeat(std::string_view p, size_t &pos) {
+      auto f = parse_atom(p, pos);
+      while (f && pos < p.size() &&
+             (p[pos] == '*' || p[pos] == '+' || p[pos] == '?')) {
+        char q = p[pos++];
+        int e = add();
+        if (q == '?') {
+          int s = add();
+          link(s, f->start);
+          link(s, e);
+          link(f->end, e);
+          f = Fragment{s, e};
+        } else {
+          // '*' may skip f, '+' goes through it once
+          int s = q == '*' ? add() : f->start;
+          if (q == '*') {
+            link(s, f->start);
+            link(s, e);
+          }
+          link(f->end, f->start);
+          link(f->end, e);
+          f = Fragment{s, e};
+        }
+      }
+      return f;
+    }
+
+    std::optional<Fragment> parse_atom(std::string_view p, size_t &pos) {
+      std::bitset<256> chars;
+
+      char ch = p[pos++];
+      switch (ch) {
+      case '(': {
+        auto f = parse_alt(p, pos);
+        if (!f || pos == p.size() || p[pos] != ')')
+          return std::nullopt;
+        ++pos;
+        return f;
+      }
+      case '[':
+        if (!parse_class(p, pos, chars))
+          return std::nullopt;
+        break;
+      case '.':
+        chars.set();
+        break;
+      case '\\':
+        if (pos == p.size())
+          return std::nullopt;
+        chars.set(static_cast<uint8_t>(p[pos++]));
+        break;
+      case '*':
+      case '+':
+      case '?':
+      case ')':
+        return std::nullopt; // nothing to repeat or unbalanced
+      default:
+        chars.set(static_cast<uint8_t>(ch));
+        break;
+      }
+
+      int s = add(), e = add();
+      states[s].chars = chars;
+      states[s].next = e;
+      return Fragment{s, e};
+    }
+
+    static bool parse_class(std::string_view p, size_t &pos,
+                            std::bitset<256> &chars) {
+      bool negated = pos < p.size() && p[pos] == '^';
+      pos += negated;
+
+      // a ']' right after '[' or '[^' is a member
+      for (bool first = true; pos < p.size() && (first || p[pos] != ']');
+           first = false) {
+        uint8_t lo = static_cast<uint8_t>(p[pos++]);
+        if (lo == '\\' && pos < p.size())
+          lo = static_cast<uint8_t>(p[pos++]);
+
+        uint8_t hi = lo;
+        if (pos + 1 < p.size() && p[pos] == '-' && p[pos + 1] != ']') {
+          hi = static_cast<uint8_t>(p[pos + 1]);
+          pos += 2;
+          if (hi < lo)
+            return false;
+        }
+
+        for (unsigned c = lo; c <= hi; ++c) {
+          chars.set(c);
+        }
+      }
+
+      if (pos == p.size())
+        return false; // no ']'
+      ++pos;
+
+      if (negated)
+        chars.flip();
+      return true;
+    }
+  };
+
+  using nfa_set = std::vector<int>; // sorted
+
+  static void closure(const Nfa &nfa, nfa_set &set) {
+    std::vector<bool> in(nfa.states.size());
+    std::vector<int> stack(set.begin(), set.end());
+    for (int s : set) {
+      in[s] = true;
+    }
+
+    while (!stack.empty()) {
+      int s = stack.back();
+      stack.pop_back();
+      for (int t : nfa.states[s].eps) {
+        if (t >= 0 && !in[t]) {
+          in[t] = true;
+          set.push_back(t);
+          stack.push_back(t);
+        }
+      }
+    }
+    std::sort(set.begin(), set.end());
+    set.erase(std::unique(set.begin(), set.end()), set.end());
+  }
+
+  //! subset construction, then the states which can't accept become DEAD
+  bool build(const Nfa &nfa, typename Nfa::Fragment fragment,
+             size_t max_states) {
+    std::map<nfa_set, uint32_t> ids;
+    std::vector<nfa_set> subsets;
+
+    nfa_set start{fragment.start};
+    closure(nfa, start);
+    ids[start] = 0;
+    subsets.push_back(std::move(start));
+
+    for (size_t i = 0; i < subsets.size(); ++i) {
+      std::array<uint32_t, 256> row;
+      row.fill(DEAD);
+
+      for (unsigned c = 0; c < 256; ++c) {
+        nfa_set target;
+        for (int s : subsets[i]) {
+          auto &state = nfa.states[s];
+          if (state.next >= 0 && state.chars.test(c))
+            target.push_back(state.next);
+        }
+        if (target.empty())
+          continue;
+
+        closure(nfa, target);
+        auto [it, inserted] =
+            ids.try_emplace(target, static_cast<uint32_t>(subsets.size()));
+        if (inserted) {
+          if (subsets.size() == max_states)
+            return false;
+          subsets.push_back(target);
+        }
+        row[c] = it->second;
+      }
+
+      trans_.push_back(row);
+      accept_.push_back(std::binary_search(subsets[i].begin(),
+                                           subsets[i].end(), fragment.end));
+    }
+
+    prune_dead_states();
+    return true;
+  }
+
+  void prune_dead_states() {
+    // live: an accepting state is reachable
+    std::vector<bool> live(accept_.begin(), accept_.end());
+    for (bool changed = true; changed;) {
+      changed = false;
+      for (size_t s = 0; s < trans_.size(); ++s) {
+        if (live[s])
+          continue;
+        for (uint32_t t : trans_[s]) {
+          if (t != DEAD && live[t]) {
+            live[s] = changed = true;
+            break;
+          }
+        }
+      }
+    }
+
+    if (!live[0]) {
+      // matches nothing
+      trans_.clear();
+      accept_.clear();
+      return;
+    }
+
+    live_chars_.resize(trans_.size());
+    for (size_t s = 0; s < trans_.size(); ++s) {
+      for (unsigned c = 0; c < 256; ++c) {
+        auto &t = trans_[s][c];
+        if (t != DEAD && !live[t])
+          t = DEAD;
+        if (t != DEAD)
+          live_chars_[s].push_back(static_cast<char>(c));
+      }
+    }
+  }
+
+  std::vector<std::array<uint32_t, 256>> trans_;
+  std::vector<bool> accept_;
+  std::vector<std::string> live_chars_;
+};
+
+//! @brief Keys of a trie matched by a PatternDfa, found lazily
+//!
+//!     Walks the product of the trie and the DFA depth first, only the
+//!     pairs of states reachable by both are visited and a branch stops as
+//!     soon as the DFA is dead. Nothing is searched before it's asked for,
+//!     so stopping after the first matches costs only what they took.
+//!
+//!     A state of the DFA with few live chars takes them as transitions,
+//!     the others enumerate the children with for_each_child. Keys come in
+//!     the order of for_each_child, i.e. sorted for the double arrays.
+//!
+//!     The trie and the DFA must outlive the range.
+template <typename Trie> class PatternMatches {
+public:
+  using state_type =
+      std::remove_cvref_t<decltype(std::declval<const Trie &>()
+                                       .traverse(std::string_view())
+                                       .state())>;
+
+  struct Match {
+    std::string_view key; // valid until the iterator is advanced
+    state_type state;
+  };
+
+  class iterator {
+    friend class PatternMatches;
+
+  public:
+    using value_type = Match;
+    using difference_type = std::ptrdiff_t;
+
+    iterator(iterator &&) = default;
+    iterator &operator=(iterator &&) = default;
+
+    // the key is pointed at here, a moved iterator has moved its key_
+    const Match &operator*() const {
+      match_.key = key_;
+      return match_;
+    }
+    const Match *operator->() const { return &**this; }
+
+    iterator &operator++() {
+      advance();
+      return *this;
+    }
+
+    void operator++(int) { advance(); }
+
+    bool operator==(std::default_sentinel_t) const { return depth_ < 0; }
+
+  private:
+    //! live chars up to this are looked up one by one
+    static constexpr size_t FEW_CHARS = 4;
+
+    struct Frame {
+      state_type state;
+      uint32_t dfa_state;
+      bool entered = false;
+      size_t next_child = 0;
+      std::vector<std::pair<char, state_type>> children;
+    };
+
+    iterator(const Trie &trie, const PatternDfa &dfa)
+        : trie_(&trie), dfa_(&dfa) {
+      if (dfa.start() == PatternDfa::DEAD)
+        return;
+
+      frames_.emplace_back();
+      frames_[0].state = trie.traverse(std::string_view()).state();
+      frames_[0].dfa_state = dfa.start();
+      depth_ = 0;
+      advance();
+    }
+
+    void enter(Frame &frame) {
+      frame.entered = true;
+      frame.next_child = 0;
+      frame.children.clear();
+
+      auto &chars = dfa_->live_chars(frame.dfa_state);
+      if (chars.size() <= FEW_CHARS) {
+        for (char ch : chars) {
+          auto res = trie_->traverse(std::string_view(&ch, 1), frame.state);
+          if (res.matched())
+            frame.children.push_back({ch, res.state()});
+        }
+      } else {
+        trie_->for_each_child(frame.state, [&](char ch, state_type child) {
+          if (dfa_->next(frame.dfa_state, ch) != PatternDfa::DEAD)
+            frame.children.push_back({ch, child});
+        });
+      }
+    }
+
+    void advance() {
+      while (depth_ >= 0) {
+        auto &frame = frames_[depth_];
+
+        if (!frame.entered) {
+          enter(frame);
+          if (dfa_->accepting(frame.dfa_state) &&
+              trie_->has_value_at(frame.state)) {
+            match_.state = frame.state;
+            return;
+          }
+        }
+
+        if (frame.next_child < frame.children.size()) {
+          auto [ch, child] = frame.children[frame.next_child++];
+          uint32_t dfa_state = dfa_->next(frame.dfa_state, ch);
+
+          key_.push_back(ch);
+          ++depth_;
+          // frames are kept, so their children keep their capacity
+          if (frames_.size() == static_cast<size_t>(depth_))
+            frames_.emplace_back();
+          auto &next = frames_[depth_];
+          next.state = child;
+          next.dfa_state = dfa_state;
+          next.entered = false;
+          continue;
+        }
+
+        if (depth_ > 0)
+          key_.pop_back();
+        --depth_;
+      }
+    }
+
+    const Trie *trie_;
+    const PatternDfa *dfa_;
+
+    std::vector<Frame> frames_;
+    std::ptrdiff_t depth_ = -1; // -1 once done
+    std::string key_;
+    mutable Match match_;
+  };
+
+  PatternMatches(const Trie &trie, const PatternDfa &dfa)
+      : trie_(trie), dfa_(dfa) {}
+
+  iterator begin() const { return iterator(trie_, dfa_); }
+  std::default_sentinel_t end() const { return {}; }
+
+private:
+  const Trie &trie_;
+  const PatternDfa &dfa_;
+};
+
+//! @brief The keys of trie matched by dfa, see PatternMatches
+template <typename Trie>
+PatternMatches<Trie> match_pattern(const Trie &trie, const PatternDfa &dfa) {
+  return PatternMatches<Trie>(trie, dfa);
+}
+
+} // namespace xtrie
+
+#endif // PATTERN_H
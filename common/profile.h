@@ -1,47 +1,133 @@
 #ifndef PROFILE_H
 #define PROFILE_H
 
-#include <Windows.h>
+#include <atomic>
 #include <cassert>
-#include <psapi.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <stdio.h>
 
-PROCESS_MEMORY_COUNTERS get_mem_info(DWORD processID) {
-  HANDLE hProcess;
-  PROCESS_MEMORY_COUNTERS pmc;
+#ifdef _WINDOWS
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <cstring>
+#include <sys/resource.h>
+#endif
+
+//! @brief Snapshot of the memory of the process
+//!
+//!     rss and peak_rss are what the OS reports (working set on Windows).
+//!     The heap fields are exact but only counted in the executables linked
+//!     with count_allocations.cpp, which replaces the global operator new /
+//!     delete and defines COUNT_ALLOCATIONS.
+struct MemInfo {
+  size_t rss = 0;      // bytes
+  size_t peak_rss = 0; // bytes
+  size_t pss = 0;      // bytes, proportional set size, Linux only
+  size_t page_faults = 0;
 
-  hProcess = OpenProcess(PROCESS_QUERY_INFORMATION | PROCESS_VM_READ, FALSE,
-                         processID);
-  assert(hProcess != nullptr);
+  size_t heap_bytes = 0;      // live bytes allocated by operator new
+  size_t heap_peak_bytes = 0; // since the last reset_heap_peak()
+  size_t heap_allocations = 0;
+};
 
-  if (GetProcessMemoryInfo(hProcess, &pmc, sizeof(pmc))) {
-    return pmc;
-  } else {
-    return {};
+namespace profile_details {
+struct HeapCounters {
+  std::atomic<size_t> bytes{0};
+  std::atomic<size_t> peak_bytes{0};
+  std::atomic<size_t> allocations{0};
+};
+
+inline HeapCounters heap_counters;
+
+#ifndef _WINDOWS
+//! value of "key: value kB" in a /proc file, in bytes, 0 if absent
+static size_t read_proc_kb(const char *path, const char *key) {
+  FILE *f = fopen(path, "r");
+  if (f == nullptr)
+    return 0;
+
+  size_t res = 0;
+  size_t key_len = strlen(key);
+
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    if (strncmp(line, key, key_len) == 0 && line[key_len] == ':') {
+      res = strtoull(line + key_len + 1, nullptr, 10) * 1024;
+      break;
+    }
   }
 
-  CloseHandle(hProcess);
+  fclose(f);
+  return res;
 }
+#endif
+} // namespace profile_details
 
-PROCESS_MEMORY_COUNTERS get_mem_info() {
-  return get_mem_info(GetCurrentProcessId());
+//! starts a new window for MemInfo::heap_peak_bytes
+inline void reset_heap_peak() {
+  auto &c = profile_details::heap_counters;
+  c.peak_bytes.store(c.bytes.load(std::memory_order_relaxed),
+                     std::memory_order_relaxed);
+}
+
+inline MemInfo get_mem_info() {
+  MemInfo res;
+
+#ifdef _WINDOWS
+  PROCESS_MEMORY_COUNTERS pmc;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+    res.rss = pmc.WorkingSetSize;
+    res.peak_rss = pmc.PeakWorkingSetSize;
+    res.page_faults = pmc.PageFaultCount;
+  }
+#else
+  res.rss = profile_details::read_proc_kb("/proc/self/status", "VmRSS");
+  res.peak_rss = profile_details::read_proc_kb("/proc/self/status", "VmHWM");
+  res.pss = profile_details::read_proc_kb("/proc/self/smaps_rollup", "Pss");
+
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) == 0) {
+    res.page_faults = static_cast<size_t>(usage.ru_minflt + usage.ru_majflt);
+  }
+#endif
+
+  auto &c = profile_details::heap_counters;
+  res.heap_bytes = c.bytes.load(std::memory_order_relaxed);
+  res.heap_peak_bytes = c.peak_bytes.load(std::memory_order_relaxed);
+  res.heap_allocations = c.allocations.load(std::memory_order_relaxed);
+
+  return res;
 }
 
-void print_mem_info(const PROCESS_MEMORY_COUNTERS &pmc) {
-  printf("\tPageFaultCount: %d\n", pmc.PageFaultCount);
-  printf("\tPeakWorkingSetSize (bytes): %lld\n", pmc.PeakWorkingSetSize);
-  printf("\tWorkingSetSize (bytes): %lld\n", pmc.WorkingSetSize);
+inline void print_mem_info(const MemInfo &info) {
+  printf("\tPageFaultCount: %zu\n", info.page_faults);
+  printf("\tPeakWorkingSetSize (bytes): %zu\n", info.peak_rss);
+  printf("\tWorkingSetSize (bytes): %zu\n", info.rss);
+#ifdef COUNT_ALLOCATIONS
+  printf("\tHeapSize (bytes): %zu\n", info.heap_bytes);
+  printf("\tHeapAllocations: %zu\n", info.heap_allocations);
+#endif
 }
 
-PROCESS_MEMORY_COUNTERS print_mem_info() {
+inline MemInfo print_mem_info() {
   auto res = get_mem_info();
   print_mem_info(res);
   return res;
 }
 
-size_t get_mem_delta(const PROCESS_MEMORY_COUNTERS &a,
-                     const PROCESS_MEMORY_COUNTERS &b) {
-  return b.WorkingSetSize - a.WorkingSetSize;
+//! @brief Memory taken between two snapshots
+//!
+//!     Exact heap bytes if allocations are counted, otherwise the growth of
+//!     the resident set, which misses freed pages and counts page reuse.
+inline ptrdiff_t get_mem_delta(const MemInfo &a, const MemInfo &b) {
+#ifdef COUNT_ALLOCATIONS
+  return static_cast<ptrdiff_t>(b.heap_bytes - a.heap_bytes);
+#else
+  return static_cast<ptrdiff_t>(b.rss - a.rss);
+#endif
 }
 
 #endif // PROFILE_H
@@ -0,0 +1,198 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <queue>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace xtrie {
+
+namespace details {
+struct RadixItem {
+  const char *key;
+  uint32_t size;
+  uint32_t index; // in the input, breaks ties
+};
+
+//! below this, a comparison sort beats another counting pass
+static constexpr size_t RADIX_SMALL_SIZE = 64;
+
+//! 0 once the key has ended, so shorter keys come first
+inline unsigned radix_digit(const RadixItem &item, size_t depth) {
+  return depth < item.size ? static_cast<unsigned char>(item.key[depth]) + 1
+                           : 0;
+}
+
+inline void radix_small_sort(RadixItem *items, size_t n, size_t depth) {
+  std::sort(items, items + n, [depth](const RadixItem &a, const RadixItem &b) {
+    int c = std::string_view(a.key + depth, a.size - depth)
+                .compare(std::string_view(b.key + depth, b.size - depth));
+    return c != 0 ? c < 0 : a.index < b.index;
+  });
+}
+
+//! @brief One stable counting sort pass on the byte at depth
+//!
+//!     Calls f(items, n) for every bucket of more than one key which still
+//!     has to be sorted from depth + 1. Keys ended at depth are all equal and
+//!     already in input order.
+template <typename F>
+void radix_pass(RadixItem *items, RadixItem *tmp, size_t n, size_t depth,
+                F &&f) {
+  size_t count[257] = {};
+  for (size_t i = 0; i < n; ++i) {
+    ++count[radix_digit(items[i], depth)];
+  }
+
+  // a prefix shared by every key, nothing moves
+  unsigned first = radix_digit(items[0], depth);
+  if (count[first] == n) {
+    if (first != 0)
+      f(items, n);
+    return;
+  }
+
+  size_t offset[257];
+  size_t sum = 0;
+  for (unsigned d = 0; d < 257; ++d) {
+    offset[d] = sum;
+    sum += count[d];
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    tmp[offset[radix_digit(items[i], depth)]++] = items[i];
+  }
+  std::copy(tmp, tmp + n, items);
+
+  size_t begin = count[0];
+  for (unsigned d = 1; d < 257; ++d) {
+    if (count[d] > 1)
+      f(items + begin, count[d]);
+    begin += count[d];
+  }
+}
+
+inline void msd_radix_sort(RadixItem *items, RadixItem *tmp, size_t n,
+                           size_t depth) {
+  if (n < RADIX_SMALL_SIZE) {
+    radix_small_sort(items, n, depth);
+    return;
+  }
+
+  radix_pass(items, tmp, n, depth, [&](RadixItem *bucket, size_t m) {
+    msd_radix_sort(bucket, tmp + (bucket - items), m, depth + 1);
+  });
+}
+} // namespace details
+
+//! @brief Order of the keys sorted by bytes, equal keys in input order
+//!
+//!     MSD radix sort. The largest buckets are split by further passes
+//!     until there are a few per thread, which takes care of the skew of
+//!     the leading bytes (e.g. the few lead bytes of CJK in UTF-8), then
+//!     the threads sort whole buckets without sharing anything.
+//!
+//! @return indices of the keys, e.g. {2, 0, 1} for {"b", "c", "a"}
+inline std::vector<uint32_t>
+radix_sort_order(std::span<const std::string_view> keys,
+                 unsigned n_threads = std::thread::hardware_concurrency()) {
+  using namespace details;
+
+  std::vector<RadixItem> items(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    items[i] = {keys[i].data(), static_cast<uint32_t>(keys[i].size()),
+                static_cast<uint32_t>(i)};
+  }
+  std::vector<RadixItem> tmp(items.size());
+
+  struct Task {
+    size_t begin;
+    size_t size;
+    size_t depth;
+
+    bool operator<(const Task &b) const { return size < b.size; }
+  };
+
+  n_threads = std::max(1u, n_threads);
+  size_t split_size = std::max<size_t>(RADIX_SMALL_SIZE,
+                                       items.size() / (n_threads * 8));
+
+  std::priority_queue<Task> big;
+  std::vector<Task> tasks;
+  if (items.size() > 1)
+    big.push({0, items.size(), 0});
+
+  while (!big.empty()) {
+    auto task = big.top();
+    big.pop();
+
+    if (n_threads == 1 || task.size <= split_size) {
+      tasks.push_back(task);
+      continue;
+    }
+
+    auto *base = items.data() + task.begin;
+    radix_pass(base, tmp.data() + task.begin, task.size, task.depth,
+               [&](RadixItem *bucket, size_t m) {
+                 big.push({static_cast<size_t>(bucket - items.data()), m,
+                           task.depth + 1});
+               });
+  }
+
+  // largest first, so no thread is left with a big one at the end
+  std::sort(tasks.rbegin(), tasks.rend());
+
+  std::atomic<size_t> next{0};
+  auto work = [&] {
+    for (size_t i; (i = next.fetch_add(1)) < tasks.size();) {
+      auto &t = tasks[i];
+      msd_radix_sort(items.data() + t.begin, tmp.data() + t.begin, t.size,
+                     t.depth);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < n_threads && i < tasks.size(); ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  std::vector<uint32_t> res(items.size());
+  for (size_t i = 0; i < items.size(); ++i) {
+    res[i] = items[i].index;
+  }
+  return res;
+}
+
+//! @brief Call f(key, value) for unsorted (key, value) pairs in key order
+//!
+//!     What add_bulk of the builders runs on. A key given more than once is
+//!     passed once, with the value it was first given.
+template <typename T, typename Range, typename F>
+void for_each_sorted_unique(const Range &pairs, F &&f, unsigned n_threads) {
+  std::vector<std::string_view> keys;
+  std::vector<T> values;
+  for (auto &[key, value] : pairs) {
+    keys.emplace_back(key);
+    values.push_back(value);
+  }
+
+  auto order = radix_sort_order(keys, n_threads);
+
+  for (size_t i = 0; i < order.size(); ++i) {
+    if (i == 0 || keys[order[i]] != keys[order[i - 1]])
+      f(keys[order[i]], values[order[i]]);
+  }
+}
+
+} // namespace xtrie
+
+#endif // RADIX_SORT_H
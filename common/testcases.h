@@ -4,11 +4,17 @@
 #include "loader.h"
 #include "profile.h"
 #include <boost/ut.hpp>
-#include <chrono>
 #include <string>
 #include <trie_concepts.h>
 #include <unordered_map>
 
+static void print_mem_usage(const char *name, const MemInfo &a,
+                            const MemInfo &b) {
+  printf("Memory usage by %s: %td bytes, peak %zu bytes, %zu page faults\n",
+         name, get_mem_delta(a, b), b.heap_peak_bytes - a.heap_bytes,
+         b.page_faults - a.page_faults);
+}
+
 template <xtrie::IsTrieBuilder TrieBuilder, typename Serializer = void>
 class BuilderCommonTests {
 public:
@@ -29,6 +35,7 @@ public:
         ++i;
     }
 
+    reset_heap_peak();
     auto mem0 = get_mem_info();
 
     i = 1;
@@ -42,8 +49,7 @@ public:
       builder_.end_build();
     }
 
-    printf("Memory usage by builder: %zd bytes\n",
-           get_mem_delta(mem0, get_mem_info()));
+    print_mem_usage("builder", mem0, get_mem_info());
   }
 
   std::string serialize() const {
@@ -77,17 +83,14 @@ public:
     return expected_kv_.at(k);
   }
 
+  //! correctness only, lookup speed is measured by the benchmark target
   bool test_all_words() const {
-    auto clk = std::chrono::steady_clock::now();
     for (auto &it : expected_kv_) {
       if (!has_value(it.first.c_str())) {
         std::cout << it.first << std::endl;
         return false;
       }
     }
-    auto diff = std::chrono::steady_clock::now() - clk;
-    std::cout << static_cast<double>(diff.count()) / 1e6 / expected_kv_.size()
-              << "ms/word" << std::endl;
     return true;
   }
 
@@ -110,12 +113,12 @@ public:
     auto bin_path = builder_.serialize();
     std::ifstream ifs(bin_path, std::ios::binary);
 
+    reset_heap_peak();
     auto mem0 = get_mem_info();
 
     trie_.load(ifs);
 
-    printf("Memory usage by trie: %zd bytes\n",
-           get_mem_delta(mem0, get_mem_info()));
+    print_mem_usage("trie", mem0, get_mem_info());
   }
 
   template <class TChar> bool has_value(const TChar *str) const {
@@ -131,17 +134,12 @@ public:
   }
 
   bool test_all_words() const {
-    auto clk = std::chrono::steady_clock::now();
     for (auto &it : builder_.expected_kv_) {
       if (!has_value(it.first.c_str())) {
         std::cout << it.first << std::endl;
         return false;
       }
     }
-    auto diff = std::chrono::steady_clock::now() - clk;
-    std::cout << static_cast<double>(diff.count()) / 1e6 /
-                     builder_.expected_kv_.size()
-              << "ms/word" << std::endl;
     return true;
   }
 
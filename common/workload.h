@@ -0,0 +1,144 @@
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+//! @brief Draw n queries from words with Zipfian popularity
+//!
+//!     The popularity rank of the words is shuffled by seed, so that hot keys
+//!     are spread over the dictionary instead of being its first entries.
+//!
+//! @param s skew, 1.0 is the classic Zipf law
+inline std::vector<std::string>
+zipf_queries(const std::vector<std::string> &words, size_t n, double s = 1.0,
+             uint32_t seed = 42) {
+  std::vector<std::string> res;
+  if (words.empty())
+    return res;
+
+  std::mt19937 rng(seed);
+
+  std::vector<size_t> rank(words.size());
+  for (size_t i = 0; i < rank.size(); ++i)
+    rank[i] = i;
+  std::shuffle(rank.begin(), rank.end(), rng);
+
+  std::vector<double> cdf(words.size());
+  double sum = 0;
+  for (size_t i = 0; i < cdf.size(); ++i) {
+    sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+    cdf[i] = sum;
+  }
+
+  std::uniform_real_distribution<double> dist(0, sum);
+
+  res.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    auto r = std::lower_bound(cdf.begin(), cdf.end(), dist(rng)) - cdf.begin();
+    res.push_back(words[rank[std::min<size_t>(r, rank.size() - 1)]]);
+  }
+
+  return res;
+}
+
+//! @brief Draw n queries which are not in words
+//!
+//!     Half of them are proper prefixes of words, they walk a path of the
+//!     trie but stop at a state without value. The other half splice the
+//!     head of a word onto the tail of another, they leave the trie midway.
+//!     Cuts are made at UTF-8 code point boundaries.
+inline std::vector<std::string>
+miss_queries(const std::vector<std::string> &words, size_t n,
+             uint32_t seed = 42) {
+  std::vector<std::string> res;
+  if (words.empty())
+    return res;
+
+  std::unordered_set<std::string> dict(words.begin(), words.end());
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<size_t> pick(0, words.size() - 1);
+
+  auto cut = [&](const std::string &w) {
+    size_t i = std::uniform_int_distribution<size_t>(0, w.size())(rng);
+    while (i < w.size() && (static_cast<uint8_t>(w[i]) & 0xC0) == 0x80)
+      ++i;
+    return i;
+  };
+
+  res.reserve(n);
+  for (size_t attempts = 0; res.size() < n && attempts < 100 * n;
+       ++attempts) {
+    const std::string &a = words[pick(rng)];
+
+    std::string q;
+    if (res.size() % 2 == 0) {
+      q = a.substr(0, cut(a));
+    } else {
+      const std::string &b = words[pick(rng)];
+      q = a.substr(0, cut(a)) + b.substr(cut(b));
+    }
+
+    if (!q.empty() && !dict.count(q))
+      res.push_back(std::move(q));
+  }
+
+  return res;
+}
+
+//! @brief Draw n words with 1 to max_edits random byte edits, e.g. for
+//! fuzzy search
+//!
+//!     An edit inserts, deletes or substitutes a byte. New bytes are taken
+//!     from other words, so that they come from the alphabet of the
+//!     lexicon.
+inline std::vector<std::string>
+typo_queries(const std::vector<std::string> &words, size_t n,
+             uint32_t max_edits, uint32_t seed = 42) {
+  std::vector<std::string> res;
+  if (words.empty() || max_edits == 0)
+    return res;
+
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<size_t> pick(0, words.size() - 1);
+
+  auto random_byte = [&] {
+    for (;;) {
+      const std::string &w = words[pick(rng)];
+      if (!w.empty())
+        return w[std::uniform_int_distribution<size_t>(0, w.size() - 1)(rng)];
+    }
+  };
+
+  res.reserve(n);
+  for (size_t i = 0; i < n; ++i) {
+    std::string q = words[pick(rng)];
+    uint32_t edits = std::uniform_int_distribution<uint32_t>(1, max_edits)(rng);
+
+    for (uint32_t e = 0; e < edits; ++e) {
+      size_t at = std::uniform_int_distribution<size_t>(0, q.size())(rng);
+      switch (q.empty() ? 0 : rng() % 3) {
+      case 0:
+        q.insert(q.begin() + at, random_byte());
+        break;
+      case 1:
+        q.erase(std::min(at, q.size() - 1), 1);
+        break;
+      default:
+        q[std::min(at, q.size() - 1)] = random_byte();
+        break;
+      }
+    }
+
+    res.push_back(std::move(q));
+  }
+
+  return res;
+}
+
+#endif // WORKLOAD_H
@@ -164,7 +164,7 @@ public:
           }
         }
         if (i >= prefix.size())
-          break;
+          return {p, true, i};
       }
 
       auto it = p->trans_by(prefix[i]);
@@ -174,6 +174,11 @@ public:
 
       p = it.target();
     }
+
+    // the value of p is at the end of its chain, which is not consumed yet
+    if (i > 0 && !p->prefix().empty())
+      return {p, false, i};
+
     return {p, true, i};
   }
 
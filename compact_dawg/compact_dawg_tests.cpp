@@ -1,6 +1,11 @@
 ﻿#include "compact_dawg.h"
+#include "flat_compact_dawg.h"
 #include <boost/ut.hpp>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 #include <testcases.h>
 
 int main() {
@@ -28,5 +33,66 @@ int main() {
     expect(node_he == node_me);
   };
 
+  "test flat compact dawg"_test = [] {
+    for (auto filename : {"en_1k.txt", "zh_cn_406k.txt"}) {
+      auto words = load_lexicon((std::string(DATA_DIR) + filename).c_str());
+      std::sort(words.begin(), words.end());
+      words.erase(std::unique(words.begin(), words.end()), words.end());
+
+      CompactDAWG dawg;
+      for (size_t i = 0; i < words.size(); ++i) {
+        dawg.add(words[i], static_cast<int>(i % 1000));
+      }
+      dawg.end_build();
+
+      FlatCompactDAWG flat;
+      flat.build(dawg);
+
+      std::stringstream ss;
+      flat.save(ss);
+      FlatCompactDAWG loaded;
+      loaded.load(ss);
+
+      std::string path = std::string(DATA_DIR) + filename + ".flat";
+      {
+        std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+        flat.save(ofs);
+      }
+      FlatCompactDAWG mapped;
+      expect(mapped.map(path.c_str()));
+
+      // keys, and prefixes and extensions of keys which may not be
+      bool same = true;
+      for (auto &w : words) {
+        for (auto q : {std::string_view(w), std::string_view(w).substr(
+                                                0, w.size() / 2)}) {
+          auto expected = dawg.traverse(q);
+          bool hit = expected.matched() && dawg.has_value_at(expected.state());
+          for (auto *trie : {&flat, &loaded, &mapped}) {
+            auto res = trie->traverse(q);
+            same &= (res.matched() && trie->has_value_at(res.state())) == hit;
+            same &= !hit || trie->value_at(res.state()) ==
+                                dawg.value_at(expected.state());
+          }
+        }
+        same &= !flat.traverse(w + "\x01").matched();
+      }
+      expect(same);
+
+      std::cout << filename << ": " << flat.n_nodes() << " nodes, "
+                << flat.size() << " bytes" << std::endl;
+
+      mapped = FlatCompactDAWG();
+      std::remove(path.c_str());
+
+      // neither a short stream nor another format is loaded
+      std::stringstream truncated(ss.str().substr(0, flat.size() / 2));
+      std::stringstream not_flat("not a flat compact DAWG");
+      FlatCompactDAWG broken;
+      expect(throws<std::invalid_argument>([&] { broken.load(truncated); }));
+      expect(throws<std::invalid_argument>([&] { broken.load(not_flat); }));
+    }
+  };
+
   return 0;
 }
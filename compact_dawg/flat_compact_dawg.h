@@ -0,0 +1,302 @@
+#ifndef FLAT_COMPACT_DAWG_H
+#define FLAT_COMPACT_DAWG_H
+
+#include "compact_dawg.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mio/mio.hpp>
+#include <queue>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef ASSERT_CONCEPT
+#include <trie_concepts.h>
+#endif
+
+namespace xtrie {
+
+//! @brief CompactDAWG flattened into one contiguous image, which is also
+//! its file format
+//!
+//!     Nodes are numbered breadth first and stored as records of two
+//!     offsets: into the label pool, where the chain collapsed into the node
+//!     (CompactDAWG::Node::prefix) is, and into the edge arrays, where its
+//!     children are, sorted by char. The next record ends both, so a node
+//!     takes 8 bytes plus its value and an edge 5 bytes, one char and one
+//!     target. Shared nodes stay shared.
+//!
+//!     A child is found with memchr over the chars of the edges and a label
+//!     is matched with memcmp, both of which libc vectorizes, instead of
+//!     one char per iteration.
+//!
+//!     The image has no pointer, save() writes it as it is and map() uses a
+//!     mapped file in place, without copying or parsing it.
+template <typename T = int, T DefaultValue = -1> class FlatCompactDAWG {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+  using value_type = T;
+  static constexpr value_type DEFAULT_VALUE = DefaultValue;
+
+  class TraverseResult {
+    friend class FlatCompactDAWG;
+
+  public:
+    uint32_t state() const { return node_; }
+    bool matched() const { return matched_; }
+    uint32_t matched_length() const { return matched_length_; }
+
+  private:
+    uint32_t node_;
+    bool matched_;
+    uint32_t matched_length_;
+
+    TraverseResult(uint32_t node, bool matched, uint32_t matched_length)
+        : node_(node), matched_(matched), matched_length_(matched_length) {}
+  };
+
+public:
+  FlatCompactDAWG() = default;
+
+  FlatCompactDAWG(const FlatCompactDAWG &) = delete;
+  FlatCompactDAWG &operator=(const FlatCompactDAWG &) = delete;
+
+  // the image doesn't move with the vector or the mapping
+  FlatCompactDAWG(FlatCompactDAWG &&) = default;
+  FlatCompactDAWG &operator=(FlatCompactDAWG &&) = default;
+
+  //! @brief Flatten a built CompactDAWG
+  void build(const CompactDAWG<T, DefaultValue> &dawg) {
+    using Node = typename CompactDAWG<T, DefaultValue>::Node;
+
+    std::vector<const Node *> nodes{dawg.traverse("").state()};
+    std::unordered_map<const Node *, uint32_t> ids{{nodes[0], 0}};
+
+    std::vector<NodeRecord> records;
+    std::vector<uint32_t> targets;
+    std::vector<T> values;
+    std::string edge_chars;
+    std::string labels;
+
+    std::vector<std::pair<unsigned char, const Node *>> children;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      const Node *node = nodes[i];
+      records.push_back({static_cast<uint32_t>(labels.size()),
+                         static_cast<uint32_t>(targets.size())});
+      values.push_back(node->value());
+      labels += node->prefix();
+
+      children.clear();
+      for (auto it = node->trans_begin(); it != node->trans_end(); ++it) {
+        children.push_back({static_cast<unsigned char>(it.key()), it.target()});
+      }
+      std::sort(children.begin(), children.end());
+
+      for (auto [ch, child] : children) {
+        auto [it, inserted] =
+            ids.insert({child, static_cast<uint32_t>(nodes.size())});
+        if (inserted)
+          nodes.push_back(child);
+
+        edge_chars += static_cast<char>(ch);
+        targets.push_back(it->second);
+      }
+    }
+    records.push_back({static_cast<uint32_t>(labels.size()),
+                       static_cast<uint32_t>(targets.size())});
+
+    Header header{MAGIC, static_cast<uint32_t>(nodes.size()),
+                  static_cast<uint32_t>(targets.size()),
+                  static_cast<uint32_t>(labels.size())};
+    auto layout = Layout::of(header);
+
+    owned_.assign(layout.size, 0);
+    char *image = owned_.data();
+    memcpy(image, &header, sizeof(header));
+    memcpy(image + layout.records, records.data(),
+           records.size() * sizeof(NodeRecord));
+    memcpy(image + layout.targets, targets.data(),
+           targets.size() * sizeof(uint32_t));
+    memcpy(image + layout.values, values.data(), values.size() * sizeof(T));
+    memcpy(image + layout.edge_chars, edge_chars.data(), edge_chars.size());
+    memcpy(image + layout.labels, labels.data(), labels.size());
+
+    bind(owned_.data(), owned_.size());
+  }
+
+  //! @return number of bytes written
+  template <typename OStream> size_t save(OStream &os) const {
+    os.write(image_, static_cast<std::streamsize>(size_));
+    return size_;
+  }
+
+  //! @brief Read an image saved by save(), copying it
+  //!
+  //!     Throws std::invalid_argument if the stream isn't a whole image.
+  template <typename IStream> void load(IStream &is) {
+    Header header;
+    is.read(reinterpret_cast<char *>(&header), sizeof(header));
+    // checked before the header sizes the image
+    if (!is || header.magic != MAGIC)
+      throw std::invalid_argument("not a flat compact DAWG");
+
+    owned_.assign(Layout::of(header).size, 0);
+    memcpy(owned_.data(), &header, sizeof(header));
+    is.read(owned_.data() + sizeof(header),
+            static_cast<std::streamsize>(owned_.size() - sizeof(header)));
+
+    if (!is || !bind(owned_.data(), owned_.size()))
+      throw std::invalid_argument("truncated flat compact DAWG");
+  }
+
+  //! @brief Use a file saved by save() in place, its pages are loaded as
+  //! lookups touch them
+  //!
+  //! @return false if the file can't be mapped or isn't a whole image
+  bool map(const char *path) {
+    std::error_code error;
+    map_.map(path, error);
+    if (error)
+      return false;
+
+    return bind(map_.data(), map_.size());
+  }
+
+  TraverseResult traverse(std::string_view prefix, uint32_t state) const {
+    uint32_t p = state;
+    uint32_t i = 0;
+    while (i < prefix.size()) {
+      // find the child of p for prefix[i], the chars are contiguous
+      uint32_t begin = records_[p].edge_begin;
+      uint32_t n = records_[p + 1].edge_begin - begin;
+      auto *found = static_cast<const char *>(
+          memchr(edge_chars_ + begin, prefix[i], n));
+      if (!found)
+        return {p, false, i};
+
+      uint32_t q = targets_[found - edge_chars_];
+      ++i;
+
+      // then the whole label of the child
+      uint32_t label_begin = records_[q].label_begin;
+      uint32_t label_size = records_[q + 1].label_begin - label_begin;
+      if (label_size > 0) {
+        size_t n_left = prefix.size() - i;
+        if (n_left < label_size ||
+            memcmp(labels_ + label_begin, prefix.data() + i, label_size) != 0) {
+          // the value of q is at the end of its label, not reached
+          size_t n_common = 0;
+          size_t n_max = std::min<size_t>(n_left, label_size);
+          while (n_common < n_max &&
+                 labels_[label_begin + n_common] == prefix[i + n_common])
+            ++n_common;
+          return {q, false, static_cast<uint32_t>(i + n_common)};
+        }
+        i += label_size;
+      }
+      p = q;
+    }
+    return {p, true, i};
+  }
+
+  TraverseResult traverse(std::string_view prefix) const {
+    return traverse(prefix, 0);
+  }
+
+  bool has_value_at(uint32_t state) const {
+    return values_[state] != DEFAULT_VALUE;
+  }
+
+  const value_type &value_at(uint32_t state) const { return values_[state]; }
+
+  size_t n_nodes() const { return n_nodes_; }
+
+  //! size of the image, in memory and on disk
+  size_t size() const { return size_; }
+
+private:
+  //! "XDWG"
+  static constexpr uint32_t MAGIC = 0x47574458;
+
+  struct Header {
+    uint32_t magic;
+    uint32_t n_nodes;
+    uint32_t n_edges;
+    uint32_t label_size;
+  };
+
+  struct NodeRecord {
+    uint32_t label_begin;
+    uint32_t edge_begin;
+  };
+
+  //! byte offsets of the arrays in the image, each aligned for its type
+  struct Layout {
+    size_t records, targets, values, edge_chars, labels, size;
+
+    static size_t align(size_t offset, size_t alignment) {
+      return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    static Layout of(const Header &h) {
+      Layout res;
+      res.records = sizeof(Header);
+      res.targets = res.records + (h.n_nodes + size_t(1)) * sizeof(NodeRecord);
+      res.values = align(res.targets + h.n_edges * sizeof(uint32_t),
+                         alignof(T));
+      res.edge_chars = res.values + h.n_nodes * sizeof(T);
+      res.labels = res.edge_chars + h.n_edges;
+      res.size = res.labels + h.label_size;
+      return res;
+    }
+  };
+
+  bool bind(const char *image, size_t size) {
+    Header header;
+    if (size < sizeof(header))
+      return false;
+    memcpy(&header, image, sizeof(header));
+
+    auto layout = Layout::of(header);
+    if (header.magic != MAGIC || header.n_nodes == 0 || size < layout.size)
+      return false;
+
+    image_ = image;
+    size_ = layout.size;
+    n_nodes_ = header.n_nodes;
+    records_ = reinterpret_cast<const NodeRecord *>(image + layout.records);
+    targets_ = reinterpret_cast<const uint32_t *>(image + layout.targets);
+    values_ = reinterpret_cast<const T *>(image + layout.values);
+    edge_chars_ = image + layout.edge_chars;
+    labels_ = image + layout.labels;
+    return true;
+  }
+
+  std::vector<char> owned_;
+  mio::mmap_source map_;
+
+  const char *image_ = nullptr;
+  size_t size_ = 0;
+  size_t n_nodes_ = 0;
+
+  const NodeRecord *records_ = nullptr;
+  const uint32_t *targets_ = nullptr;
+  const T *values_ = nullptr;
+  const char *edge_chars_ = nullptr;
+  const char *labels_ = nullptr;
+};
+
+#ifdef ASSERT_CONCEPT
+static_assert(IsKVTrie<FlatCompactDAWG<>>);
+static_assert(IsDeserializableTrie<FlatCompactDAWG<>>);
+#endif
+
+} // namespace xtrie
+
+#endif // FLAT_COMPACT_DAWG_H
@@ -0,0 +1,221 @@
+#ifndef DATRIE_ACCESS_PROFILE_H
+#define DATRIE_ACCESS_PROFILE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace xtrie {
+
+//! @brief Profiling policy of the runtime tries which records nothing
+//!
+//!     All members are empty inlines, traverse compiles as if there were no
+//!     policy at all.
+struct NoAccessProfile {
+  static constexpr bool enabled = false;
+
+  void resize(size_t) {}
+  void visit(unsigned, uint32_t) const {}
+};
+
+static_assert(std::is_empty_v<NoAccessProfile>);
+
+//! @brief Profiling policy of the runtime tries which counts state visits
+//!
+//!     Every traverse step counts a visit of the reached state and a hit of
+//!     its depth (relative to the state traverse started from, the start
+//!     state is counted at depth 0).
+//!
+//!     Each thread counts into its own block, so lookups don't contend on
+//!     shared cache lines. merge() sums the blocks on demand, it may run
+//!     concurrently with lookups but then sees a slightly stale count.
+class AccessProfile {
+public:
+  static constexpr bool enabled = true;
+  static constexpr uint32_t MAX_DEPTH = 256;
+
+  struct Stats {
+    std::vector<uint64_t> state_visits;
+    std::vector<uint64_t> depth_hits; // deeper steps are counted at the end
+  };
+
+  //! prefix and the number of traversals which ended at its state
+  using weights_type = std::vector<std::pair<std::string, uint64_t>>;
+
+public:
+  AccessProfile() : id_(next_id()) {}
+
+  AccessProfile(const AccessProfile &) = delete;
+  AccessProfile &operator=(const AccessProfile &) = delete;
+
+  //! called by the trie on load, drops the counts so far
+  void resize(size_t n_states) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    n_states_ = n_states;
+    counters_.clear();
+    // invalidate the thread caches
+    id_.store(next_id(), std::memory_order_release);
+  }
+
+  void visit(unsigned state, uint32_t depth) const {
+    Counters &c = local_counters();
+    bump(c.state_visits[state]);
+    bump(c.depth_hits[depth < MAX_DEPTH ? depth : MAX_DEPTH - 1]);
+  }
+
+  Stats merge() const {
+    constexpr auto relaxed = std::memory_order_relaxed;
+
+    Stats res;
+    res.state_visits.assign(n_states_, 0);
+    res.depth_hits.assign(MAX_DEPTH, 0);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &[thread_id, c] : counters_) {
+      for (size_t i = 0; i < n_states_; ++i)
+        res.state_visits[i] += c->state_visits[i].load(relaxed);
+      for (size_t i = 0; i < MAX_DEPTH; ++i)
+        res.depth_hits[i] += c->depth_hits[i].load(relaxed);
+    }
+
+    while (!res.depth_hits.empty() && res.depth_hits.back() == 0)
+      res.depth_hits.pop_back();
+
+    return res;
+  }
+
+  //! @brief Turn the visits into weights for DoubleArrayTrieBuilder
+  //!
+  //!     The weight of a prefix is the number of traversals which stopped at
+  //!     its state, add_weight accumulates them back to the visits.
+  //!
+  //! @param for_each_child called as for_each_child(state, f), f is called
+  //! as f(char, child state) for every transition of state
+  template <typename ForEachChild>
+  weights_type export_weights(ForEachChild &&for_each_child) const {
+    weights_type res;
+
+    auto stats = merge();
+    if (stats.state_visits.empty())
+      return res;
+
+    std::vector<std::pair<unsigned, std::string>> stack{{0, ""}};
+    while (!stack.empty()) {
+      auto [state, prefix] = std::move(stack.back());
+      stack.pop_back();
+
+      uint64_t stopped = stats.state_visits[state];
+      for_each_child(state, [&](char ch, unsigned child) {
+        uint64_t n = stats.state_visits[child];
+        if (n == 0)
+          return;
+
+        stopped -= std::min(stopped, n);
+        stack.push_back({child, prefix + ch});
+      });
+
+      if (stopped > 0)
+        res.push_back({std::move(prefix), stopped});
+    }
+
+    return res;
+  }
+
+  //! one "prefix\tweight" line per entry
+  static void write_weights(std::ostream &os, const weights_type &weights) {
+    for (auto &[prefix, weight] : weights) {
+      os << prefix << '\t' << weight << '\n';
+    }
+  }
+
+  static weights_type read_weights(std::istream &is) {
+    weights_type res;
+
+    std::string line;
+    while (std::getline(is, line)) {
+      auto tab_i = line.rfind('\t');
+      if (tab_i == std::string::npos)
+        continue;
+
+      res.push_back({line.substr(0, tab_i),
+                     std::stoull(line.substr(tab_i + 1))});
+    }
+
+    return res;
+  }
+
+private:
+  struct Counters {
+    Counters(size_t n_states)
+        : state_visits(new std::atomic<uint64_t>[n_states]()),
+          depth_hits(new std::atomic<uint64_t>[MAX_DEPTH]()) {}
+
+    std::unique_ptr<std::atomic<uint64_t>[]> state_visits;
+    std::unique_ptr<std::atomic<uint64_t>[]> depth_hits;
+  };
+
+  //! @brief The counters of the last profiles a thread visited
+  //!
+  //!     Keyed by id, ids are never reused, so the slot of a profile
+  //!     destroyed or resized since never matches again.
+  struct LocalCache {
+    static constexpr size_t N_SLOTS = 8;
+
+    struct Slot {
+      uint64_t id = 0;
+      Counters *counters = nullptr;
+    };
+
+    Slot slots[N_SLOTS];
+    size_t next = 0; // slot replaced on a miss, round robin
+  };
+
+  static uint64_t next_id() {
+    static std::atomic<uint64_t> id{1};
+    return id.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  //! only the owning thread writes, so no read-modify-write is needed
+  static void bump(std::atomic<uint64_t> &n) {
+    n.store(n.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  Counters &local_counters() const {
+    thread_local LocalCache cache;
+    uint64_t id = id_.load(std::memory_order_acquire);
+    for (auto &slot : cache.slots) {
+      if (slot.id == id)
+        return *slot.counters;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto &c = counters_[std::this_thread::get_id()];
+    if (!c)
+      c = std::make_unique<Counters>(n_states_);
+
+    cache.slots[cache.next] = {id_.load(std::memory_order_relaxed), c.get()};
+    cache.next = (cache.next + 1) % LocalCache::N_SLOTS;
+    return *c;
+  }
+
+  std::atomic<uint64_t> id_;
+  size_t n_states_ = 0;
+
+  mutable std::mutex mutex_;
+  mutable std::unordered_map<std::thread::id, std::unique_ptr<Counters>>
+      counters_;
+};
+
+} // namespace xtrie
+
+#endif // DATRIE_ACCESS_PROFILE_H
@@ -0,0 +1,225 @@
+#ifndef DATRIE_ALPHABET_H
+#define DATRIE_ALPHABET_H
+
+#include "trans_set.h"
+#include "utf8.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace xtrie {
+
+namespace details {
+//! @brief Charmap of the byte alphabets
+//!
+//! @tparam OrderPreserving ids follow the byte order instead of the
+//!         frequency
+template <bool OrderPreserving> class ByteCharmap {
+public:
+  void build(const std::unordered_map<uint8_t, size_t> &freq) {
+    std::fill(charmap_, charmap_ + MAX_CHAR_VAL + 1, 0);
+
+    std::vector<std::pair<size_t, uint8_t>> sorted_char_freq;
+    for (auto &[ch, n] : freq) {
+      sorted_char_freq.push_back({n, ch});
+    }
+
+    if constexpr (OrderPreserving) {
+      std::sort(sorted_char_freq.begin(), sorted_char_freq.end(),
+                [](const auto &a, const auto &b) {
+                  return a.second < b.second;
+                });
+    } else {
+      std::sort(sorted_char_freq.begin(), sorted_char_freq.end(),
+                std::greater<std::pair<size_t, uint8_t>>());
+    }
+
+    assert(sorted_char_freq.size() < MAX_CHAR_VAL); // 0 will never appear
+
+    for (uint8_t i = 0; i < static_cast<uint8_t>(sorted_char_freq.size());
+         ++i) {
+      assert(sorted_char_freq[i].second != 0);
+      charmap_[sorted_char_freq[i].second] = i + 1; // keep 0 as null char
+    }
+  }
+
+  uint32_t operator[](uint8_t ch) const { return charmap_[ch]; }
+
+  //! serialized size in bytes
+  uint32_t size() const { return sizeof(charmap_); }
+
+  template <typename OStream> void save(OStream &os) const {
+    os.write(reinterpret_cast<const char *>(charmap_), sizeof(charmap_));
+  }
+
+private:
+  static constexpr uint32_t MAX_CHAR_VAL = std::numeric_limits<uint8_t>::max();
+
+  uint8_t charmap_[MAX_CHAR_VAL + 1];
+};
+} // namespace details
+
+//! @brief Alphabet of the double array: every byte is a transition
+//!
+//!     The charmap maps the most frequent byte to the least id, ids fit in the
+//!     8-bit check field of the serialized unit.
+struct ByteAlphabet {
+  using symbol_type = uint8_t;
+  using trans_set_type = TransSet;
+
+  //! size of a unit of the runtime array
+  static constexpr uint32_t UNIT_SIZE = sizeof(uint32_t);
+
+  using Charmap = details::ByteCharmap<false>;
+
+  static symbol_type decode(std::string_view sv, size_t i, uint32_t &len) {
+    len = 1;
+    return static_cast<symbol_type>(sv[i]);
+  }
+
+  //! @brief Enumerate the labelled transitions of a DAWG node
+  //!
+  //! @param f called as f(symbol, target node)
+  template <typename Node, typename F>
+  static void for_each_trans(const Node *node, F &&f) {
+    for (auto it = node->trans_begin(); it != node->trans_end(); ++it) {
+      f(static_cast<symbol_type>(it.key()), it.target());
+    }
+  }
+};
+
+//! @brief ByteAlphabet whose ids are dense in byte order
+//!
+//!     The children of a state then lie in key order in the array, and an
+//!     id compares like the byte it maps. The ranking by frequency is lost,
+//!     it packs the frequent transitions at the low offsets which are
+//!     easier to place. The serialized format is the one of ByteAlphabet.
+struct OrderedByteAlphabet : ByteAlphabet {
+  using Charmap = details::ByteCharmap<true>;
+};
+
+//! @brief Alphabet of the double array: every UTF-8 code point is a transition
+//!
+//!     A CJK character costs one transition instead of three. Code points are
+//!     ranked by frequency like bytes, the ids need a check field wider than
+//!     8 bits (see WideSerializer).
+//!
+//!     The serialized charmap is the symbol count followed by the symbol of
+//!     every id, the runtime rebuilds the lookup table from it.
+struct Utf8Alphabet {
+  using symbol_type = uint32_t;
+  using trans_set_type = SymbolSet;
+
+  //! size of a unit of the runtime array
+  static constexpr uint32_t UNIT_SIZE = sizeof(uint64_t);
+
+  class Charmap {
+  public:
+    void build(const std::unordered_map<symbol_type, size_t> &freq) {
+      std::vector<std::pair<size_t, symbol_type>> sorted_char_freq;
+      for (auto &[ch, n] : freq) {
+        sorted_char_freq.push_back({n, ch});
+      }
+
+      // ties are broken by the symbol so that the layout is deterministic
+      std::sort(sorted_char_freq.begin(), sorted_char_freq.end(),
+                [](const auto &a, const auto &b) {
+                  return a.first != b.first ? a.first > b.first
+                                            : a.second < b.second;
+                });
+
+      symbols_.clear();
+      for (auto &[n, ch] : sorted_char_freq) {
+        symbols_.push_back(ch);
+      }
+
+      table_.assign(symbols_);
+    }
+
+    uint32_t operator[](symbol_type ch) const { return table_[ch]; }
+
+    //! serialized size in bytes
+    uint32_t size() const {
+      return static_cast<uint32_t>(sizeof(uint32_t) * (symbols_.size() + 1));
+    }
+
+    template <typename OStream> void save(OStream &os) const {
+      uint32_t n = static_cast<uint32_t>(symbols_.size());
+      os.write(reinterpret_cast<const char *>(&n), sizeof(uint32_t));
+      os.write(reinterpret_cast<const char *>(symbols_.data()),
+               sizeof(uint32_t) * n);
+    }
+
+  private:
+    std::vector<symbol_type> symbols_;
+    utf8::SymbolTable table_;
+  };
+
+  static symbol_type decode(std::string_view sv, size_t i, uint32_t &len) {
+    return utf8::decode(sv.data() + i, sv.size() - i, len);
+  }
+
+  //! @brief Enumerate the code point transitions of a DAWG node
+  //!
+  //!     The DAWG is labelled by bytes, so the continuation bytes of a
+  //!     sequence are walked here. A lead byte also yields its raw-byte
+  //!     symbol if some key stops short of a well-formed sequence after it,
+  //!     which is exactly when utf8::decode would fall back to it.
+  //!
+  //! @param f called as f(symbol, target node)
+  template <typename Node, typename F>
+  static void for_each_trans(const Node *node, F &&f) {
+    for (auto it = node->trans_begin(); it != node->trans_end(); ++it) {
+      uint8_t lead = static_cast<uint8_t>(it.key());
+      uint32_t seq = utf8::sequence_length(lead);
+
+      if (seq == 1) {
+        f(static_cast<symbol_type>(lead), it.target());
+        continue;
+      }
+
+      char buf[4] = {it.key()};
+      if (seq == 0 || walk_sequence(it.target(), buf, 1, seq, f)) {
+        f(utf8::RAW_BYTE_BASE + lead, it.target());
+      }
+    }
+  }
+
+private:
+  //! @return whether some key leaves the sequence before it is complete
+  template <typename Node, typename F>
+  static bool walk_sequence(const Node *node, char *buf, uint32_t depth,
+                            uint32_t seq, F &f) {
+    if (depth == seq) {
+      uint32_t len;
+      symbol_type symbol = utf8::decode(buf, seq, len);
+      if (len != seq)
+        return true; // overlong or out of range
+
+      f(symbol, node);
+      return false;
+    }
+
+    bool broken = node->has_value();
+    for (auto it = node->trans_begin(); it != node->trans_end(); ++it) {
+      if (!utf8::is_continuation(static_cast<uint8_t>(it.key()))) {
+        broken = true;
+        continue;
+      }
+
+      buf[depth] = it.key();
+      broken |= walk_sequence(it.target(), buf, depth + 1, seq, f);
+    }
+
+    return broken;
+  }
+};
+
+} // namespace xtrie
+
+#endif // DATRIE_ALPHABET_H
@@ -0,0 +1,190 @@
+#ifndef ANY_TRIE_H
+#define ANY_TRIE_H
+
+#include "compact_datrie.h"
+#include "dawg_datrie.h"
+#include "default_datrie.h"
+#include "no_value_datrie.h"
+#include "packed_datrie.h"
+#include "serializers/format.h"
+#include "utf8.h"
+#include "utf8_datrie.h"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace xtrie {
+
+//! @brief Double array trie of any saved format, detected on load
+//!
+//!     Holds one of the runtime tries with their default parameters and
+//!     dispatches to it once per call, the traversal itself runs the
+//!     concrete trie without indirection. Batches of keys are dispatched
+//!     once per batch.
+//!
+//!     Files need the format header, which DoubleArrayTrieBuilder::save
+//!     writes for every serializer of the repo.
+class AnyTrie {
+public:
+  //! wide enough for the values of every runtime
+  using value_type = int64_t;
+
+public:
+  //! @brief Detect the format and load the trie
+  //!
+  //!     The stream must be seekable, the concrete trie reads the header
+  //!     again.
+  //!
+  //! @return false if the format is unknown, the trie is empty then
+  template <typename IStream> bool load(IStream &is) {
+    auto pos = is.tellg();
+
+    uint32_t size_sum;
+    format_ = read_format_header(is, size_sum);
+    is.seekg(pos);
+
+    switch (format_) {
+    case TrieFormat::NO_VALUE:
+      trie_.emplace<NoValueDoubleArrayTrie<>>().load(is);
+      return true;
+    case TrieFormat::DEFAULT:
+      trie_.emplace<DefaultDoubleArrayTrie<>>().load(is);
+      return true;
+    case TrieFormat::DEFAULT64:
+      trie_.emplace<DefaultDoubleArrayTrie<int64_t>>().load(is);
+      return true;
+    case TrieFormat::COMPACT:
+      trie_.emplace<CompactDoubleArrayTrie<>>().load(is);
+      return true;
+    case TrieFormat::WIDE:
+      trie_.emplace<Utf8DoubleArrayTrie<>>().load(is);
+      return true;
+    case TrieFormat::DAWG:
+      trie_.emplace<DawgDoubleArrayTrie<>>().load(is);
+      return true;
+    case TrieFormat::PACKED:
+      trie_.emplace<PackedDoubleArrayTrie<>>().load(is);
+      return true;
+    case TrieFormat::PACKED64:
+      trie_.emplace<PackedDoubleArrayTrie<int64_t>>().load(is);
+      return true;
+    default:
+      format_ = TrieFormat::UNKNOWN;
+      trie_.emplace<std::monostate>();
+      return false;
+    }
+  }
+
+  TrieFormat format() const { return format_; }
+
+  //! false if the trie only tells whether a key exists, lookup returns 0 as
+  //! the value of every key then
+  bool has_values() const { return format_ != TrieFormat::NO_VALUE; }
+
+  std::optional<value_type> lookup(std::string_view key) const {
+    return std::visit(
+        [&](const auto &trie) -> std::optional<value_type> {
+          if constexpr (IS_TRIE<decltype(trie)>) {
+            return lookup(trie, key);
+          } else {
+            return std::nullopt;
+          }
+        },
+        trie_);
+  }
+
+  std::vector<std::optional<value_type>>
+  lookup(std::span<const std::string_view> keys) const {
+    std::vector<std::optional<value_type>> res(keys.size());
+
+    std::visit(
+        [&](const auto &trie) {
+          if constexpr (IS_TRIE<decltype(trie)>) {
+            for (size_t i = 0; i < keys.size(); ++i) {
+              res[i] = lookup(trie, keys[i]);
+            }
+          }
+        },
+        trie_);
+
+    return res;
+  }
+
+  //! @brief Find every key which is a prefix of s, shortest first
+  //!
+  //! @param f called as f(length of the key, value)
+  template <typename F>
+  void common_prefix_search(std::string_view s, F &&f) const {
+    std::visit(
+        [&](const auto &trie) {
+          if constexpr (IS_TRIE<decltype(trie)>) {
+            common_prefix_search(trie, s, f);
+          }
+        },
+        trie_);
+  }
+
+private:
+  template <typename T>
+  static constexpr bool IS_TRIE =
+      !std::is_same_v<std::remove_cvref_t<T>, std::monostate>;
+
+  template <typename Trie, typename State>
+  static value_type value_of(const Trie &trie, State state) {
+    if constexpr (requires { trie.value_at(state); }) {
+      return static_cast<value_type>(trie.value_at(state));
+    } else {
+      return 0;
+    }
+  }
+
+  template <typename Trie>
+  static std::optional<value_type> lookup(const Trie &trie,
+                                          std::string_view key) {
+    auto res = trie.traverse(key);
+    if (!res.matched() || !trie.has_value_at(res.state()))
+      return std::nullopt;
+
+    return value_of(trie, res.state());
+  }
+
+  template <typename Trie, typename F>
+  static void common_prefix_search(const Trie &trie, std::string_view s,
+                                   F &f) {
+    auto state = trie.traverse("").state();
+    if (trie.has_value_at(state))
+      f(size_t{0}, value_of(trie, state));
+
+    uint32_t len = 1;
+    for (size_t i = 0; i < s.size(); i += len) {
+      // a transition of the utf8 trie is a whole code point
+      if constexpr (std::is_same_v<Trie, Utf8DoubleArrayTrie<>>) {
+        utf8::decode(s.data() + i, s.size() - i, len);
+      }
+
+      auto res = trie.traverse(s.substr(i, len), state);
+      if (!res.matched())
+        return;
+
+      state = res.state();
+      if (trie.has_value_at(state))
+        f(i + len, value_of(trie, state));
+    }
+  }
+
+  TrieFormat format_ = TrieFormat::UNKNOWN;
+  std::variant<std::monostate, NoValueDoubleArrayTrie<>,
+               DefaultDoubleArrayTrie<>, DefaultDoubleArrayTrie<int64_t>,
+               CompactDoubleArrayTrie<>, Utf8DoubleArrayTrie<>,
+               DawgDoubleArrayTrie<>, PackedDoubleArrayTrie<>,
+               PackedDoubleArrayTrie<int64_t>>
+      trie_;
+};
+
+} // namespace xtrie
+
+#endif // ANY_TRIE_H
@@ -0,0 +1,154 @@
+#ifndef BLOB_DATRIE_H
+#define BLOB_DATRIE_H
+
+#include "blob_pool.h"
+#include "default_datrie.h"
+#include "serializers/format.h"
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <ios>
+#include <memory>
+#include <mio/mio.hpp>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#ifdef ASSERT_CONCEPT
+#include <trie_concepts.h>
+#endif
+
+namespace xtrie {
+
+//! @brief Double array trie whose values are byte strings of any length, see
+//! BlobDoubleArrayTrieBuilder
+//!
+//!     The double array is a DefaultDoubleArrayTrie of uint32_t offsets into
+//!     a BlobPool, value_at returns a view into the pool, without copying
+//!     it: into the loaded copy after load(), into the file after map().
+//!
+//!     The states without a key have the offset of the empty string, an
+//!     empty value is no value.
+template <template <typename> class Allocator = std::allocator>
+class BlobDoubleArrayTrie {
+  using trie_type =
+      DefaultDoubleArrayTrie<uint32_t, BlobPool::EMPTY, NoAccessProfile,
+                             Allocator>;
+
+public:
+  using value_type = std::string_view;
+  static constexpr value_type DEFAULT_VALUE{};
+
+  using TraverseResult = typename trie_type::TraverseResult;
+
+  BlobDoubleArrayTrie() = default;
+
+  BlobDoubleArrayTrie(const BlobDoubleArrayTrie &) = delete;
+  BlobDoubleArrayTrie &operator=(const BlobDoubleArrayTrie &) = delete;
+
+  // the pool doesn't move with the vector or the mapping
+  BlobDoubleArrayTrie(BlobDoubleArrayTrie &&) = default;
+  BlobDoubleArrayTrie &operator=(BlobDoubleArrayTrie &&) = default;
+
+  //! @brief Read a trie saved by BlobDoubleArrayTrieBuilder, copying its
+  //! pool
+  template <typename IStream> void load(IStream &is) {
+    uint32_t pool_size;
+    [[maybe_unused]] auto format = read_format_header(is, pool_size);
+    assert(format == TrieFormat::BLOB);
+
+    owned_.resize(padded(pool_size));
+    is.read(owned_.data(), static_cast<std::streamsize>(owned_.size()));
+    pool_ = {owned_.data(), pool_size};
+
+    trie_.load(is);
+  }
+
+  //! @brief Use the pool of a file saved by BlobDoubleArrayTrieBuilder in
+  //! place, only the double array is copied
+  //!
+  //! @return false if the file can't be mapped or isn't a blob trie
+  bool map(const char *path) {
+    std::error_code error;
+    map_.map(path, error);
+    if (error)
+      return false;
+
+    MemoryReader reader{map_.data(), map_.data() + map_.size()};
+    uint32_t pool_size;
+    if (read_format_header(reader, pool_size) != TrieFormat::BLOB ||
+        reader.remaining() < padded(pool_size))
+      return false;
+
+    pool_ = {reader.p, pool_size};
+    reader.p += padded(pool_size);
+
+    trie_.load(reader);
+    return !reader.overrun;
+  }
+
+  TraverseResult traverse(std::string_view prefix, unsigned state) const {
+    return trie_.traverse(prefix, state);
+  }
+
+  TraverseResult traverse(std::string_view prefix) const {
+    return trie_.traverse(prefix);
+  }
+
+  bool has_value_at(unsigned state) const {
+    return trie_.value_at(state) != BlobPool::EMPTY;
+  }
+
+  value_type value_at(unsigned state) const {
+    return pool_.at(trie_.value_at(state));
+  }
+
+  template <typename F> void for_each_child(unsigned state, F &&f) const {
+    trie_.for_each_child(state, f);
+  }
+
+  //! number of units, the used ones and the free ones
+  size_t n_units() const { return trie_.n_units(); }
+
+  //! the empty string and the distinct values
+  const BlobPool &pool() const { return pool_; }
+
+private:
+  //! the pool is padded to 4 bytes, the units after it stay aligned
+  static size_t padded(size_t size) { return (size + 3) / 4 * 4; }
+
+  //! the is.read() the loaders need, over a mapped file
+  struct MemoryReader {
+    const char *p;
+    const char *end;
+    bool overrun = false;
+
+    size_t remaining() const { return static_cast<size_t>(end - p); }
+
+    void read(char *buf, std::streamsize n) {
+      auto size = static_cast<size_t>(n);
+      if (size > remaining()) {
+        overrun = true;
+        memset(buf, 0, size);
+        return;
+      }
+      memcpy(buf, p, size);
+      p += size;
+    }
+  };
+
+  std::vector<char> owned_;
+  mio::mmap_source map_;
+
+  BlobPool pool_;
+  trie_type trie_;
+};
+
+#ifdef ASSERT_CONCEPT
+static_assert(IsDeserializableTrie<BlobDoubleArrayTrie<>>);
+static_assert(IsKVTrie<BlobDoubleArrayTrie<>>);
+#endif
+
+} // namespace xtrie
+
+#endif // BLOB_DATRIE_H
@@ -0,0 +1,91 @@
+#ifndef BLOB_DATRIE_BUILDER_H
+#define BLOB_DATRIE_BUILDER_H
+
+#include "blob_pool.h"
+#include "datrie_builder.h"
+#include "serializers/default_serializer.h"
+#include "serializers/format.h"
+#include <cstdint>
+#include <radix_sort.h>
+#include <string_view>
+#include <thread>
+
+#ifdef ASSERT_CONCEPT
+#include <trie_concepts.h>
+#endif
+
+namespace xtrie {
+
+//! @brief Builder for BlobDoubleArrayTrie, whose values are byte strings,
+//! e.g. readings, tags or JSON
+//!
+//!     The values go into a BlobPoolBuilder, each distinct one once, and the
+//!     keys into a DoubleArrayTrieBuilder with their offset in the pool as
+//!     value. An empty value is the offset of the states without a key, the
+//!     key is not added.
+//!
+//!     The file is the format header, the pool padded to 4 bytes and then
+//!     the double array as DefaultSerializer writes it.
+class BlobDoubleArrayTrieBuilder {
+  using builder_type = DoubleArrayTrieBuilder<uint32_t, BlobPool::EMPTY>;
+
+public:
+  using value_type = std::string_view;
+  static constexpr value_type DEFAULT_VALUE{};
+
+  void add(std::string_view sv, std::string_view blob) {
+    if (!blob.empty())
+      builder_.add(sv, pool_.add(blob));
+  }
+
+  //! @brief Add (key, blob) pairs in any order, see DAWG::add_bulk
+  //!
+  //!     A key added more than once keeps its first blob, even an empty one,
+  //!     and only that blob goes into the pool.
+  template <typename Range>
+  void add_bulk(const Range &pairs,
+                unsigned n_threads = std::thread::hardware_concurrency()) {
+    for_each_sorted_unique<std::string_view>(
+        pairs,
+        [&](std::string_view key, std::string_view blob) { add(key, blob); },
+        n_threads);
+  }
+
+  void end_build() { builder_.end_build(); }
+
+  //! @return number of bytes written
+  template <typename OStream> size_t save(OStream &os) const {
+    details::CountingOStream<OStream> counting{os};
+    auto pool = pool_.pool();
+    write_format_header(counting, TrieFormat::BLOB);
+    auto pool_size = static_cast<uint32_t>(pool.size());
+    counting.write(reinterpret_cast<const char *>(&pool_size),
+                   sizeof(uint32_t));
+
+    const char padding[4] = {};
+    size_t n_padding = (4 - pool.size() % 4) % 4;
+    counting.write(pool.data(), static_cast<std::streamsize>(pool.size()));
+    counting.write(padding, static_cast<std::streamsize>(n_padding));
+
+    builder_.save(counting, DefaultSerializer{});
+    return counting.n_bytes;
+  }
+
+  //! @brief Timings and metrics of the double array, see BuildReport
+  const BuildReport &build_report() const { return builder_.build_report(); }
+
+  //! number of distinct non empty blobs
+  size_t n_blobs() const { return pool_.n_blobs(); }
+
+private:
+  BlobPoolBuilder pool_;
+  builder_type builder_;
+};
+
+#ifdef ASSERT_CONCEPT
+static_assert(IsStaticTrieBuilder<BlobDoubleArrayTrieBuilder>);
+#endif
+
+} // namespace xtrie
+
+#endif // BLOB_DATRIE_BUILDER_H
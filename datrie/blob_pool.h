@@ -0,0 +1,89 @@
+#ifndef DATRIE_BLOB_POOL_H
+#define DATRIE_BLOB_POOL_H
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace xtrie {
+
+//! @brief Byte strings of any length stored back to back, each preceded by
+//! its length as a LEB128 varint, and found by offset
+//!
+//!     Offset 0 is the empty string, so that the offset 0 a double array
+//!     gives to the states without a key reads as an empty value.
+class BlobPool {
+public:
+  static constexpr uint32_t EMPTY = 0;
+
+  BlobPool() = default;
+  BlobPool(const char *data, size_t size) : data_(data), size_(size) {}
+
+  std::string_view at(uint32_t offset) const {
+    assert(offset < size_);
+    const auto *p = reinterpret_cast<const uint8_t *>(data_ + offset);
+
+    size_t length = 0;
+    for (unsigned shift = 0;; shift += 7) {
+      length |= static_cast<size_t>(*p & 0x7f) << shift;
+      if ((*p++ & 0x80) == 0)
+        break;
+    }
+    return {reinterpret_cast<const char *>(p), length};
+  }
+
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+//! @brief Appends the strings of a BlobPool, each distinct one once
+class BlobPoolBuilder {
+public:
+  BlobPoolBuilder() : pool_(1, '\0') {} // the empty string, at 0
+
+  //! @return offset of blob in the pool
+  uint32_t add(std::string_view blob) {
+    if (blob.empty())
+      return BlobPool::EMPTY;
+
+    auto it = offsets_.find(std::string(blob));
+    if (it != offsets_.end())
+      return it->second;
+
+    if (pool_.size() + blob.size() + 10 > std::numeric_limits<uint32_t>::max())
+      throw std::length_error("blob pool larger than 4 GB");
+
+    auto offset = static_cast<uint32_t>(pool_.size());
+    size_t length = blob.size();
+    do {
+      uint8_t byte = length & 0x7f;
+      length >>= 7;
+      pool_.push_back(static_cast<char>(length > 0 ? byte | 0x80 : byte));
+    } while (length > 0);
+    pool_.append(blob);
+
+    offsets_.emplace(blob, offset);
+    return offset;
+  }
+
+  BlobPool pool() const { return {pool_.data(), pool_.size()}; }
+
+  //! number of distinct non empty blobs
+  size_t n_blobs() const { return offsets_.size(); }
+
+private:
+  std::string pool_;
+  std::unordered_map<std::string, uint32_t> offsets_;
+};
+
+} // namespace xtrie
+
+#endif // DATRIE_BLOB_POOL_H
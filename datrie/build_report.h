@@ -0,0 +1,137 @@
+#ifndef DATRIE_BUILD_REPORT_H
+#define DATRIE_BUILD_REPORT_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace xtrie {
+
+//! @brief What DoubleArrayTrieBuilder did, phase by phase, and the shape of
+//! the array it made
+//!
+//!     The phases are the ones of end_build, in order, then the save when
+//!     the report is given to save(), each with its wall time and the peak
+//!     resident memory of the process when it ended. The DAWG is minimized
+//!     while the keys are added, its phase is only the last minimization.
+struct BuildReport {
+  struct Phase {
+    std::string name;
+    double seconds = 0;
+    size_t peak_rss_bytes = 0; // 0 if unknown
+  };
+
+  std::vector<Phase> phases;
+
+  size_t n_dawg_states = 0;
+  // length of the chains of states with one transition and no value
+  std::map<size_t, size_t> single_branch_length_to_count;
+
+  size_t n_units = 0;
+  size_t n_free_units = 0; // wasted, inside the array
+  size_t max_base = 0;
+
+  size_t n_placements = 0; // states whose children were placed
+  size_t n_probes = 0;     // bases tried for them, first fit ones included
+
+  size_t saved_bytes = 0; // 0 until saved with the report
+
+  double seconds() const {
+    double res = 0;
+    for (auto &phase : phases) {
+      res += phase.seconds;
+    }
+    return res;
+  }
+
+  size_t peak_rss_bytes() const {
+    size_t res = 0;
+    for (auto &phase : phases) {
+      res = std::max(res, phase.peak_rss_bytes);
+    }
+    return res;
+  }
+
+  double fill_rate() const {
+    return n_units == 0 ? 0.0
+                        : static_cast<double>(n_units - n_free_units) /
+                              static_cast<double>(n_units);
+  }
+
+  double probes_per_placement() const {
+    return n_placements == 0 ? 0.0
+                             : static_cast<double>(n_probes) /
+                                   static_cast<double>(n_placements);
+  }
+
+  //! @brief Run f as the phase name and append its timing
+  template <typename F> void time(const char *name, F &&f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    phases.push_back({name, std::chrono::duration<double>(end - start).count(),
+                      current_peak_rss_bytes()});
+  }
+
+  //! @brief One JSON object, phases in order
+  std::string to_json() const {
+    std::string res = "{\"phases\": [";
+    for (size_t i = 0; i < phases.size(); ++i) {
+      append(res, "%s{\"name\": \"%s\", \"seconds\": %.6f, "
+                  "\"peak_rss_bytes\": %zu}",
+             i == 0 ? "" : ", ", phases[i].name.c_str(), phases[i].seconds,
+             phases[i].peak_rss_bytes);
+    }
+    append(res, "], \"seconds\": %.6f, \"peak_rss_bytes\": %zu", seconds(),
+           peak_rss_bytes());
+    append(res, ", \"n_dawg_states\": %zu, \"n_units\": %zu", n_dawg_states,
+           n_units);
+    append(res, ", \"n_free_units\": %zu, \"fill_rate\": %.6f", n_free_units,
+           fill_rate());
+    append(res, ", \"max_base\": %zu, \"n_placements\": %zu", max_base,
+           n_placements);
+    append(res, ", \"n_probes\": %zu, \"probes_per_placement\": %.3f",
+           n_probes, probes_per_placement());
+    append(res, ", \"saved_bytes\": %zu", saved_bytes);
+
+    res += ", \"single_branch_length_to_count\": {";
+    bool first = true;
+    for (auto [length, count] : single_branch_length_to_count) {
+      append(res, "%s\"%zu\": %zu", first ? "" : ", ", length, count);
+      first = false;
+    }
+    res += "}}";
+    return res;
+  }
+
+  //! @brief Peak resident memory of the process so far, 0 if unknown
+  static size_t current_peak_rss_bytes() {
+#ifdef __linux__
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+      return static_cast<size_t>(usage.ru_maxrss) * 1024; // in KB on Linux
+#endif
+    return 0;
+  }
+
+private:
+  template <typename... Args>
+  static void append(std::string &s, const char *format, Args... args) {
+    char buf[256];
+    int n = snprintf(buf, sizeof(buf), format, args...);
+    s.append(buf, static_cast<size_t>(std::clamp(n, 0, int(sizeof(buf)) - 1)));
+  }
+};
+
+} // namespace xtrie
+
+#endif // DATRIE_BUILD_REPORT_H
@@ -1,6 +1,10 @@
 #ifndef DATRIE_BUILDER_H
 #define DATRIE_BUILDER_H
 
+#include "alphabet.h"
+#include "build_report.h"
+#include "file_backed_array.h"
+#include "serializers/format.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
@@ -8,17 +12,15 @@
 #include <hashtrie.h>
 #include <limits>
 #include <queue>
+#include <radix_sort.h>
 #include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
-#ifdef _WINDOWS
-#include <intrin.h>
-
-#pragma intrinsic(_BitScanForward64)
-#pragma intrinsic(_BitScanReverse64)
-#endif
-
 #ifdef ASSERT_CONCEPT
 #include <trie_concepts.h>
 #endif
@@ -32,195 +34,20 @@ template <typename T>
 struct has_end_build<T, std::void_t<decltype(&T::end_build)>> : std::true_type {
 };
 
-static inline unsigned char _bit_scan_forward(unsigned long *index,
-                                              uint64_t data) {
-  if (data == 0)
-    return 0;
-
-  unsigned long res = 0;
-
-  do {
-    if (data & 1) {
-      *index = res;
-      return 1;
-    }
-
-    data >>= 1;
-    ++res;
-  } while (data > 0);
-
-  assert(false);
-  return 1;
-}
-
-static inline unsigned char bit_scan_forward(unsigned long *index,
-                                             uint64_t data) {
-#ifdef _WINDOWS
-  return _BitScanForward64(index, data);
-#else
-  return _bit_scan_forward(index, data);
-#endif
-}
-
-static inline unsigned char _bit_scan_reverse(unsigned long *index,
-                                              uint64_t data) {
-  if (data == 0)
-    return 0;
-
-  unsigned long res = 0;
-
-  do {
-    if (data & (1ULL << 63)) {
-      *index = 63 - res;
-      return 1;
-    }
-
-    data <<= 1;
-    ++res;
-  } while (data > 0);
-
-  assert(false);
-  return 1;
-}
-
-static inline unsigned char bit_scan_reverse(unsigned long *index,
-                                             uint64_t data) {
-#ifdef _WINDOWS
-  return _BitScanReverse64(index, data);
-#else
-  return _bit_scan_reverse(index, data);
-#endif
-}
-
-} // namespace details
-
-class TransSet {
-public:
-  class Iterator {
-  public:
-    Iterator(const uint64_t *data)
-        : iter_data_{data[0], data[1], data[2], data[3]} {}
-
-    bool end() {
-      return iter_data_[0] == 0 && iter_data_[1] == 0 && iter_data_[2] == 0 &&
-             iter_data_[3] == 0;
-    }
-
-    Iterator &operator++() {
-      using namespace details;
-
-      unsigned long index;
-
-      if (bit_scan_forward(&index, iter_data_[0])) {
-        iter_data_[0] &= ~(1ULL << index);
-      } else if (bit_scan_forward(&index, iter_data_[1])) {
-        iter_data_[1] &= ~(1ULL << index);
-      } else if (bit_scan_forward(&index, iter_data_[2])) {
-        iter_data_[2] &= ~(1ULL << index);
-      } else if (bit_scan_forward(&index, iter_data_[3])) {
-        iter_data_[3] &= ~(1ULL << index);
-      }
-
-      return *this;
-    }
-
-    unsigned long trans() const {
-      using namespace details;
-
-      unsigned long index;
-
-      if (bit_scan_forward(&index, iter_data_[0])) {
-        return index;
-      } else if (bit_scan_forward(&index, iter_data_[1])) {
-        return index + 64;
-      } else if (bit_scan_forward(&index, iter_data_[2])) {
-        return index + 64 * 2;
-      } else if (bit_scan_forward(&index, iter_data_[3])) {
-        return index + 64 * 3;
-      }
-
-      return 0; // invalid, no trans
-    }
-
-  private:
-    uint64_t iter_data_[4];
-  };
-
-public:
-  TransSet() : data_{0, 0, 0, 0} {}
-
-  void add(uint8_t ch) {
-    if (ch < 64) {
-      data_[0] |= (1ULL << ch);
-    } else if (ch < 64 * 2) {
-      data_[1] |= (1ULL << (ch - 64));
-    } else if (ch < 64 * 3) {
-      data_[2] |= (1ULL << (ch - 64 * 2));
-    } else {
-      data_[3] |= (1ULL << (ch - 64 * 3));
-    }
-  }
-
-  const uint64_t *data() const { return data_; }
-
-  bool empty() const {
-    return data_[0] == 0 && data_[1] == 0 && data_[2] == 0 && data_[3] == 0;
-  }
-
-  bool has(uint8_t ch) const {
-    if (ch < 64) {
-      return data_[0] & (1ULL << ch);
-    } else if (ch < 64 * 2) {
-      return data_[1] & (1ULL << (ch - 64));
-    } else if (ch < 64 * 3) {
-      return data_[2] & (1ULL << (ch - 64 * 2));
-    } else {
-      return data_[3] & (1ULL << (ch - 64 * 3));
-    }
-  }
-
-  Iterator begin() const { return {data_}; }
-
-  unsigned long front() const {
-    using namespace details;
+//! @brief Output stream which counts the bytes written to os, whether or not
+//! os has tellp
+template <typename OStream> struct CountingOStream {
+  OStream &os;
+  size_t n_bytes = 0;
 
-    unsigned long index;
-
-    if (bit_scan_forward(&index, data_[0])) {
-      return index;
-    } else if (bit_scan_forward(&index, data_[1])) {
-      return index + 64;
-    } else if (bit_scan_forward(&index, data_[2])) {
-      return index + 64 * 2;
-    } else if (bit_scan_forward(&index, data_[3])) {
-      return index + 64 * 3;
-    }
-
-    return 0; // invalid, no trans
+  void write(const char *data, std::streamsize n) {
+    os.write(data, n);
+    n_bytes += static_cast<size_t>(n);
   }
-
-  unsigned long back() const {
-    using namespace details;
-
-    unsigned long index;
-
-    if (bit_scan_reverse(&index, data_[3])) {
-      return index + 64 * 3;
-    } else if (bit_scan_reverse(&index, data_[2])) {
-      return index + 64 * 2;
-    } else if (bit_scan_reverse(&index, data_[1])) {
-      return index + 64;
-    } else if (bit_scan_reverse(&index, data_[0])) {
-      return index;
-    }
-
-    return 0; // invalid, no trans
-  }
-
-private:
-  uint64_t data_[4];
 };
 
+} // namespace details
+
 //! @brief Builder for DoubleArrayTrie
 //!
 //!     We don't consider the size of the array element in builder.
@@ -234,9 +61,20 @@ private:
 //!     compact. We should be enable to calculate the compression rate it
 //!     brings, so, we need a switch to disable this charmap feature.
 //!
+//!     The alphabet decides what a transition is: a byte (ByteAlphabet) or a
+//!     UTF-8 code point (Utf8Alphabet).
+//!
+//!     The arrays are std::vector by default, FileBackedArray keeps them in
+//!     mapped files for tries larger than memory (see
+//!     ExternalDoubleArrayTrieBuilder).
+//!
 //! @tparam T value type
+//! @tparam Alphabet ByteAlphabet, OrderedByteAlphabet or Utf8Alphabet
+//! @tparam Array std::vector or FileBackedArray
 template <typename T = int, T DefaultValue = -1,
-          bool CompactValueIntoArray = false>
+          bool CompactValueIntoArray = false,
+          typename Alphabet = ByteAlphabet,
+          template <typename> class Array = std::vector>
 class DoubleArrayTrieBuilder {
   static_assert(!CompactValueIntoArray || sizeof(T) <= sizeof(uint32_t));
 
@@ -244,6 +82,7 @@ public:
   using internal_trie_type = DAWG<T, DefaultValue>;
   using value_type = typename internal_trie_type::value_type;
   static constexpr value_type DEFAULT_VALUE = internal_trie_type::DEFAULT_VALUE;
+  using alphabet_type = Alphabet;
 
 public:
   class TraverseResult {
@@ -271,11 +110,12 @@ public:
     int64_t p = state_index;
 
     uint32_t i = 0;
-    for (; i < prefix.size(); ++i) {
-      uint8_t mapped_ch = charmap_[static_cast<uint8_t>(prefix[i])];
+    uint32_t len = 1;
+    for (; i < prefix.size(); i += len) {
+      uint32_t mapped_ch = charmap_[Alphabet::decode(prefix, i, len)];
       assert(base_[p] > 0);
       int64_t new_base = base_[p] + mapped_ch;
-      if (static_cast<size_t>(new_base) < check_.size() &&
+      if (mapped_ch != 0 && static_cast<size_t>(new_base) < check_.size() &&
           check_[new_base] == mapped_ch) {
         p = new_base;
       } else {
@@ -294,7 +134,6 @@ public:
       auto s = base_[state_index];
       if (value_[state_index] == 1) {
         if (s < base_.size()) {
-          assert(check_[s] == 1);
           return static_cast<value_type>(base_[s]);
         }
         return DEFAULT_VALUE;
@@ -319,120 +158,169 @@ public:
 
     build_->trie.add(sv, value);
 
-    for (char c : sv) {
-      ++build_->char_freq[c];
+    uint32_t len;
+    for (size_t i = 0; i < sv.size(); i += len) {
+      ++build_->char_freq[Alphabet::decode(sv, i, len)];
     }
   }
 
-  void end_build() {
+  //! @brief Add (key, value) pairs in any order, see DAWG::add_bulk
+  template <typename Range>
+  void add_bulk(const Range &pairs,
+                unsigned n_threads = std::thread::hardware_concurrency()) {
+    for_each_sorted_unique<T>(
+        pairs, [&](std::string_view key, T value) { add(key, value); },
+        n_threads);
+  }
+
+  //! @brief Add the access weight of a string, e.g. its count in a query log
+  //!
+  //!     The weight is accumulated on every prefix of sv, so queries that are
+  //!     not keys count for the states they pass. Heavier states are placed
+  //!     first, hot paths then share the head of the array, and the children
+  //!     of a weighted state are kept on one cache line when they fit.
+  //!     Without any weight, states are placed in BFS order.
+  void add_weight(std::string_view sv, uint64_t weight) {
     assert(base_.empty());
 
-    if constexpr (details::has_end_build<internal_trie_type>::value) {
-      build_->trie.end_build();
+    uint64_t h = PREFIX_HASH_SEED;
+    build_->prefix_weight[h] += weight;
+
+    uint32_t len;
+    for (size_t i = 0; i < sv.size(); i += len) {
+      h = hash_trans(h, Alphabet::decode(sv, i, len));
+      build_->prefix_weight[h] += weight;
     }
+  }
 
-    build_charmap();
-    build_states();
-    build_post_meta_data();
+  //! @brief add_weight for every (string, weight) pair, e.g. the weights
+  //! exported by AccessProfile
+  template <typename Range> void add_weights(const Range &weights) {
+    for (auto &[sv, weight] : weights) {
+      add_weight(sv, weight);
+    }
+  }
+
+  void end_build() {
+    assert(base_.empty());
+
+    report_ = BuildReport();
+    report_.time("dawg", [this] {
+      if constexpr (details::has_end_build<internal_trie_type>::value) {
+        build_->trie.end_build();
+      }
+    });
+    report_.time("charmap", [this] { build_charmap(); });
+    report_.time("states", [this] { build_states(); });
+    report_.time("trim", [this] { trim(); });
+    collect_dawg_metrics();
 
     build_.reset(nullptr);
   }
 
+  //! @brief Timings and metrics of end_build
+  const BuildReport &build_report() const { return report_; }
+
+  //! @brief Write the trie with a serializer
   template <typename OStream, typename F>
   size_t save(OStream &os, F &&serialize_base_check_value) const {
     assert(base_.size() == check_.size());
     assert(base_.size() == value_.size());
 
-    constexpr uint32_t charmap_size = sizeof(uint8_t) * (MAX_CHAR_VAL + 1);
-
-    uint32_t size_sum = charmap_size;
-
+    uint32_t size_sum = charmap_.size();
     size_sum += static_cast<uint32_t>(serialize_base_check_value.get_size(
         base_, check_, value_, DEFAULT_VALUE));
 
+    using serializer_type = std::remove_cvref_t<F>;
+    if constexpr (requires { serializer_type::FORMAT; }) {
+      write_format_header(os,
+                          value_format(serializer_type::FORMAT, sizeof(T)));
+    }
+
     os.write(reinterpret_cast<char *>(&size_sum), sizeof(uint32_t));
-    os.write(reinterpret_cast<const char *>(charmap_), charmap_size);
+    charmap_.save(os);
 
     serialize_base_check_value(os, base_, check_, value_, DEFAULT_VALUE);
+    return size_sum;
+  }
 
+  //! @brief Write the trie, and append the save phase and saved_bytes to
+  //! report, e.g. a copy of build_report()
+  //!
+  //!     The builder itself is not changed, so saves may run concurrently.
+  template <typename OStream, typename F>
+  size_t save(OStream &os, F &&serialize_base_check_value,
+              BuildReport &report) const {
+    details::CountingOStream<OStream> counting{os};
+    size_t size_sum = 0;
+    report.time("save", [&] {
+      size_sum = save(counting, std::forward<F>(serialize_base_check_value));
+    });
+    report.saved_bytes = counting.n_bytes;
     return size_sum;
   }
 
 private:
-  static constexpr uint32_t MAX_CHAR_VAL = std::numeric_limits<uint8_t>::max();
+  using symbol_type = typename Alphabet::symbol_type;
+  using trans_set_type = typename Alphabet::trans_set_type;
 
   struct BuildInfo {
     // internal trie
     internal_trie_type trie;
 
     // meta info calculated from input words
-    std::unordered_map<char, size_t> char_freq;
+    std::unordered_map<symbol_type, size_t> char_freq;
 
-    char rev_charmap[MAX_CHAR_VAL + 1];
-  };
+    // access weight by the hash of the prefix
+    std::unordered_map<uint64_t, uint64_t> prefix_weight;
 
-  struct PostMetaData {
-    size_t max_base = 0;
+    // check only stores the label, so two states must never share a base,
+    // or each would take the children of the other for its own
+    std::vector<bool> used_bases;
+  };
 
-    size_t base_size = 0;
-    size_t state_size = 0;
+  struct PendingState {
+    uint64_t weight;
+    uint64_t order;
+    const typename internal_trie_type::Node *node;
+    uint32_t base;
+    uint64_t prefix_hash;
 
-    size_t n_free_base = 0;
-    std::unordered_map<size_t, size_t> single_branch_length_to_count;
+    bool operator<(const PendingState &b) const {
+      // heavier first, then first in first out
+      return weight != b.weight ? weight < b.weight : order > b.order;
+    }
   };
 
 private:
-  std::unique_ptr<BuildInfo> build_;
+  static constexpr uint64_t PREFIX_HASH_SEED = 0xCBF29CE484222325ULL;
 
-  // constructed things
-  uint8_t charmap_[MAX_CHAR_VAL + 1];
+  // check of the unit holding the value in CompactValueIntoArray mode, marks
+  // it as used but never equals a label
+  static constexpr int64_t VALUE_SLOT_CHECK =
+      std::numeric_limits<int64_t>::max();
+  static constexpr uint32_t UNITS_PER_CACHE_LINE = 64 / Alphabet::UNIT_SIZE;
 
-  std::vector<int64_t> base_;
-  std::vector<int64_t> check_;
-  std::vector<T> value_;
+  std::unique_ptr<BuildInfo> build_;
 
-  PostMetaData post_;
+  // constructed things
+  typename Alphabet::Charmap charmap_;
 
-  void build_post_meta_data() {
-    post_.max_base =
-        static_cast<size_t>(*std::max_element(base_.begin(), base_.end()));
-    post_.base_size = base_.size();
+  Array<int64_t> base_;
+  Array<int64_t> check_;
+  Array<T> value_;
 
-    for (size_t i = 0; i < base_.size(); ++i) {
-      if (free(i))
-        ++post_.n_free_base;
-    }
+  BuildReport report_;
 
+  void collect_dawg_metrics() {
     auto metrics = build_->trie.collect_metrics();
-    post_.state_size = metrics.state_size;
-    post_.single_branch_length_to_count =
-        std::move(metrics.single_branch_length_to_count);
+    report_.n_dawg_states = metrics.state_size;
+    report_.single_branch_length_to_count.insert(
+        metrics.single_branch_length_to_count.begin(),
+        metrics.single_branch_length_to_count.end());
   }
 
-  void build_charmap() {
-    std::fill(charmap_, charmap_ + MAX_CHAR_VAL + 1, 0);
-    std::fill(build_->rev_charmap, build_->rev_charmap + MAX_CHAR_VAL + 1, 0);
-
-    std::vector<std::pair<size_t, char>> sorted_char_freq;
-    for (auto &[ch, n] : build_->char_freq) {
-      sorted_char_freq.push_back({n, ch});
-    }
-
-    std::sort(sorted_char_freq.begin(), sorted_char_freq.end(),
-              std::greater<std::pair<size_t, char>>());
-
-    static_assert(std::numeric_limits<unsigned char>::max() <=
-                  std::numeric_limits<uint8_t>::max());
-    assert(sorted_char_freq.size() < MAX_CHAR_VAL); // 0 will never appear
-
-    for (uint8_t i = 0; i < static_cast<uint8_t>(sorted_char_freq.size());
-         ++i) {
-      assert(sorted_char_freq[i].second != 0);
-      charmap_[static_cast<uint8_t>(sorted_char_freq[i].second)] =
-          i + 1; // keep 0 as null char
-      build_->rev_charmap[i + 1] = sorted_char_freq[i].second;
-    }
-  }
+  void build_charmap() { charmap_.build(build_->char_freq); }
 
   bool overflow(size_t i) const { return i >= check_.size(); }
   bool free(size_t i) const {
@@ -462,7 +350,7 @@ private:
     value_.resize(n + 1, DefaultValue);
   }
 
-  bool fit_trans(uint32_t base, const TransSet &trans_set) const {
+  bool fit_trans(uint32_t base, const trans_set_type &trans_set) const {
     // 0 is null char
     assert(overflow(base) || free(base)); // free to place front
 
@@ -511,15 +399,65 @@ private:
     check_[for_base] = -static_cast<int64_t>(next_free_index);
   }
 
-  uint32_t find_or_allocate_free_base(const TransSet &trans_set) {
+  static uint64_t hash_trans(uint64_t h, symbol_type ch) {
+    h = (h + ch + 1) * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 32);
+  }
+
+  bool used_base(size_t base) const {
+    return base < build_->used_bases.size() && build_->used_bases[base];
+  }
+
+  //! @brief Reset the free list links and value slot marks once built
+  //!
+  //!     Saved as they are, a link could equal a label and be taken for a
+  //!     transition. Ids start from 1, so check 0 never matches.
+  void clear_free_units() {
+    for (size_t i = 0; i < check_.size(); ++i) {
+      if (check_[i] == VALUE_SLOT_CHECK) {
+        check_[i] = 0; // base keeps the value
+      } else if (check_[i] <= 0) {
+        if (i != 0) // root
+          base_[i] = 0;
+        check_[i] = 0;
+      }
+    }
+  }
+
+  uint64_t weight_of(uint64_t prefix_hash) const {
+    auto it = build_->prefix_weight.find(prefix_hash);
+    return it == build_->prefix_weight.end() ? 0 : it->second;
+  }
+
+  //! whether the trans would span two cache lines if front is put at base
+  bool cross_cache_line(uint32_t base, const trans_set_type &trans_set) const {
+    return base / UNITS_PER_CACHE_LINE !=
+           (base + trans_set.back() - trans_set.front()) / UNITS_PER_CACHE_LINE;
+  }
+
+  uint32_t find_or_allocate_free_base(const trans_set_type &trans_set,
+                                      bool same_cache_line = false) {
     uint32_t base = next_free_base(0);
 
     auto front = trans_set.front();
     while (base <= front)
       base = next_free_base(base);
 
-    while (!fit_trans(base, trans_set))
+    same_cache_line &=
+        trans_set.back() - trans_set.front() < UNITS_PER_CACHE_LINE;
+
+    ++report_.n_placements;
+    ++report_.n_probes;
+    while (!fit_trans(base, trans_set) || used_base(base - front) ||
+           (same_cache_line && cross_cache_line(base, trans_set))) {
       base = next_free_base(base);
+      ++report_.n_probes;
+    }
+
+    auto &used_bases = build_->used_bases;
+    if (base - front >= used_bases.size())
+      used_bases.resize((base - front + 1) * 2);
+    used_bases[base - front] = true;
 
     uint32_t max_next = base + trans_set.back();
     if (overflow(max_next)) {
@@ -530,25 +468,37 @@ private:
   }
 
   void build_states() {
+    using node_type = typename internal_trie_type::Node;
+
     resize(1);
 
-    std::queue<std::pair<const typename internal_trie_type::Node *, uint32_t>>
-        q; // node and base
-    q.push({build_->trie.traverse("").state(), 0});
+    bool weighted = !build_->prefix_weight.empty();
+    uint64_t order = 0;
+
+    std::priority_queue<PendingState> q;
+    q.push({weight_of(PREFIX_HASH_SEED), order++,
+            build_->trie.traverse("").state(), 0, PREFIX_HASH_SEED});
+
+    // mapped trans, its target and symbol, sorted like the trans set
+    std::vector<std::tuple<uint32_t, const node_type *, symbol_type>> targets;
 
     while (!q.empty()) {
-      auto [node, node_base] = q.front();
+      auto [node_weight, node_order, node, node_base, node_hash] = q.top();
       q.pop();
 
       // Construct trans set
-      TransSet trans_set;
-      for (auto it = node->trans_begin(); it != node->trans_end(); ++it) {
-        auto ch = static_cast<uint8_t>(it.key());
+      trans_set_type trans_set;
+      targets.clear();
+      Alphabet::for_each_trans(node, [&](symbol_type ch,
+                                         const node_type *target) {
         assert(ch > 0);
 
-        ch = charmap_[ch];
-        trans_set.add(ch);
-      }
+        auto mapped_ch = charmap_[ch];
+        trans_set.add(mapped_ch);
+        targets.push_back({mapped_ch, target, ch});
+      });
+      std::sort(targets.begin(), targets.end());
+      auto target_it = targets.begin();
 
       if constexpr (CompactValueIntoArray) {
         if (trans_set.empty()) {
@@ -574,7 +524,8 @@ private:
         }
       }
 
-      uint32_t start_base = find_or_allocate_free_base(trans_set);
+      uint32_t start_base =
+          find_or_allocate_free_base(trans_set, node_weight > 0);
 
       // assign
       for (auto it = trans_set.begin(); !it.end(); ++it) {
@@ -589,8 +540,7 @@ private:
         if constexpr (CompactValueIntoArray) {
           if (it.trans() == 0) {
             base_[current_base] = node->value();
-            check_[current_base] =
-                1; // just mark it for used, any non-zero value is ok
+            check_[current_base] = VALUE_SLOT_CHECK;
             value_[node_base] = 1; // just mark it has value
             continue;
           }
@@ -600,33 +550,67 @@ private:
         check_[current_base] = it.trans();
 
         // get next state node and store value
-        assert(it.trans() < 256);
-        auto next_node =
-            node->trans_by(build_->rev_charmap[it.trans()]).target();
+        assert(target_it != targets.end() &&
+               std::get<0>(*target_it) == it.trans());
+        auto [mapped_ch, next_node, ch] = *(target_it++);
 
         if constexpr (!CompactValueIntoArray) {
           value_[current_base] = next_node->value();
         }
 
-        q.push({next_node, current_base});
+        if (weighted) {
+          auto next_hash = hash_trans(node_hash, ch);
+          q.push({weight_of(next_hash), order++, next_node,
+                  static_cast<uint32_t>(current_base), next_hash});
+        } else {
+          q.push({0, order++, next_node, static_cast<uint32_t>(current_base),
+                  0});
+        }
       }
 
       // update base of the "from" state node
       base_[node_base] = start_base - trans_set.front();
     }
+  }
 
+  //! @brief Drop the free units at the end, then reset the free ones left
+  void trim() {
+    // the root is kept even if the trie is empty
     size_t last_unused = base_.size() - 1;
-    while (last_unused >= 0 && free(last_unused))
+    while (last_unused > 0 && free(last_unused))
       --last_unused;
 
     resize(last_unused);
+
+    report_.max_base =
+        static_cast<size_t>(*std::max_element(base_.begin(), base_.end()));
+    report_.n_units = base_.size();
+    for (size_t i = 1; i < base_.size(); ++i) { // the root is used
+      if (free(i))
+        ++report_.n_free_units;
+    }
+
+    clear_free_units();
   }
 };
 
+//! @brief Builder whose arrays live in mapped files
+//!
+//!     Feed it the keys in order, e.g. from ExternalSorter::merge, the DAWG
+//!     is then minimized while the keys stream in and only the base / check
+//!     pages being placed need to stay resident.
+template <typename T = int, T DefaultValue = -1,
+          bool CompactValueIntoArray = false,
+          typename Alphabet = ByteAlphabet>
+using ExternalDoubleArrayTrieBuilder =
+    DoubleArrayTrieBuilder<T, DefaultValue, CompactValueIntoArray, Alphabet,
+                           FileBackedArray>;
+
 #ifdef ASSERT_CONCEPT
 static_assert(IsKVTrie<DoubleArrayTrieBuilder<>>);
 static_assert(IsStaticTrieBuilder<DoubleArrayTrieBuilder<>>);
 static_assert(IsSerializableTrieBuilder<DoubleArrayTrieBuilder<>>);
+static_assert(IsSerializableTrieBuilder<ExternalDoubleArrayTrieBuilder<>>);
 #endif
 
 } // namespace xtrie
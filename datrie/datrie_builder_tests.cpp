@@ -2,8 +2,15 @@
 #include "serializers/compact_serializer.h"
 #include "serializers/default_serializer.h"
 #include "serializers/no_value_serializer.h"
+#include "serializers/wide_serializer.h"
 #include <algorithm>
 #include <boost/ut.hpp>
+#include <cstdio>
+#include <external_sort.h>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
 #include <string_view>
 #include <testcases.h>
 #include <vector>
@@ -89,11 +96,231 @@ int main() {
     expect(builder.value_at(it.state()) == 1);
   };
 
+  "test utf8::decode"_test = [] {
+    auto test = [](std::string_view s, uint32_t expected,
+                   uint32_t expected_len) {
+      uint32_t len;
+      expect(utf8::decode(s.data(), s.size(), len) == expected);
+      expect(len == expected_len);
+    };
+
+    test("a", 'a', 1);
+    test("\xE4\xB8\xAD\xE6\x96\x87", 0x4E2D, 3); // zhong wen
+    test("\xC3\xA9", 0xE9, 2);
+    test("\xF0\x9F\x98\x80", 0x1F600, 4);
+    test("\xE4\xB8", utf8::RAW_BYTE_BASE + 0xE4, 1);    // truncated
+    test("\xE4\x41\x41", utf8::RAW_BYTE_BASE + 0xE4, 1); // no continuation
+    test("\xE0\x81\x81", utf8::RAW_BYTE_BASE + 0xE0, 1); // overlong 'A'
+    test("\x80", utf8::RAW_BYTE_BASE + 0x80, 1);
+  };
+
+  "test utf8 alphabet build"_test = [] {
+    DoubleArrayTrieBuilder<int, -1, false, Utf8Alphabet> builder;
+
+    std::vector<std::string> words{"\xE4\xB8\xAD",
+                                   "\xE4\xB8\xAD\xE6\x96\x87",
+                                   "\xE4\xB8\xADx",
+                                   "\xE4\xB8",
+                                   "\xE4\xB8\x41",
+                                   "abc"};
+    std::sort(words.begin(), words.end());
+
+    for (size_t i = 0; i < words.size(); ++i) {
+      builder.add(words[i], static_cast<int>(i));
+    }
+    builder.end_build();
+
+    for (size_t i = 0; i < words.size(); ++i) {
+      auto it = builder.traverse(words[i]);
+      expect(it.matched());
+      expect(it.matched_length() == words[i].size());
+      expect(builder.value_at(it.state()) == static_cast<int>(i));
+    }
+
+    auto it = builder.traverse("\xE4\xB8\xAD\xE6\x96\x88");
+    expect(!it.matched());
+    expect(it.matched_length() == 3_u);
+  };
+
+  "test mapped lexicon"_test = [] {
+    // big enough to be parsed by several threads
+    std::string path = std::string(DATA_DIR) + "mapped_lexicon_test.txt";
+    {
+      std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+      for (int i = 0; i < 400000; ++i) {
+        ofs << "key" << i;
+        if (i % 3 == 0)
+          ofs << '\t' << i;
+        else if (i % 3 == 1)
+          ofs << "\tnot a number";
+        ofs << (i % 5 == 0 ? "\r\n" : "\n");
+      }
+      ofs << "last\t-7"; // no newline at the end
+    }
+
+    {
+      MappedLexicon<int> lexicon(path.c_str(), -1, 4);
+      expect(lexicon.size() == 400001_u);
+
+      bool all_parsed = true;
+      for (int i = 0; i < 400000; ++i) {
+        all_parsed &=
+            lexicon.keys()[i].compare("key" + std::to_string(i)) == 0 &&
+            lexicon.values()[i] == (i % 3 == 0 ? i : -1);
+      }
+      expect(all_parsed);
+      expect(lexicon.keys().back().compare("last") == 0 &&
+             lexicon.values().back() == -7);
+
+      DoubleArrayTrieBuilder<> builder;
+      std::vector<size_t> order(lexicon.size());
+      for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+      }
+      std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return lexicon.keys()[a] < lexicon.keys()[b];
+      });
+      for (auto i : order) {
+        builder.add(lexicon.keys()[i], lexicon.values()[i]);
+      }
+      builder.end_build();
+
+      auto res = builder.traverse("key300");
+      expect(res.matched() && builder.value_at(res.state()) == 300);
+    }
+    std::remove(path.c_str());
+
+    MappedLexicon<int> zh(DATA_DIR "zh_cn_406k.txt", 0);
+    auto words = load_lexicon(DATA_DIR "zh_cn_406k.txt");
+    expect(std::equal(words.begin(), words.end(), zh.keys().begin(),
+                      zh.keys().end()));
+
+    MappedLexicon<int> missing(DATA_DIR "no_such_file.txt", 0);
+    expect(missing.empty());
+  };
+
+  "test add_bulk"_test = [] {
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    expect(!words.empty());
+
+    // shuffled, every third key twice
+    std::vector<std::pair<std::string_view, int>> pairs;
+    for (size_t i = 0; i < words.size(); ++i) {
+      pairs.emplace_back(words[i], static_cast<int>(words[i].size()));
+      if (i % 3 == 0)
+        pairs.emplace_back(words[i], static_cast<int>(words[i].size()));
+    }
+    std::shuffle(pairs.begin(), pairs.end(), std::mt19937(42));
+
+    DoubleArrayTrieBuilder<int, -1, false, Utf8Alphabet> bulk;
+    bulk.add_bulk(pairs, 4);
+    bulk.end_build();
+
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    DoubleArrayTrieBuilder<int, -1, false, Utf8Alphabet> sorted;
+    for (auto &w : words) {
+      sorted.add(w, static_cast<int>(w.size()));
+    }
+    sorted.end_build();
+
+    std::stringstream a, b;
+    bulk.save(a, WideSerializer{});
+    sorted.save(b, WideSerializer{});
+    expect(a.str() == b.str());
+  };
+
+  "test external build"_test = [] {
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    // small enough for several runs, unsorted and with duplicates
+    ExternalSorter<int> sorter(4096);
+    for (auto it = words.rbegin(); it != words.rend(); ++it) {
+      sorter.add(*it, static_cast<int>(it->size()));
+    }
+    for (auto &w : words) {
+      sorter.add(w, -2); // added last, must not win
+    }
+    expect(sorter.run_count() > 1_u);
+
+    ExternalDoubleArrayTrieBuilder<> external;
+    std::vector<std::string> merged;
+    sorter.merge([&](std::string_view key, int value) {
+      merged.emplace_back(key);
+      external.add(key, value);
+    });
+    external.end_build();
+    expect(merged == words);
+
+    DoubleArrayTrieBuilder<> in_memory;
+    for (auto &w : words) {
+      in_memory.add(w, static_cast<int>(w.size()));
+    }
+    in_memory.end_build();
+
+    std::stringstream a, b;
+    external.save(a, DefaultSerializer{});
+    in_memory.save(b, DefaultSerializer{});
+    expect(a.str() == b.str());
+
+    // fits in the budget, merged without any run
+    ExternalSorter<int> small;
+    for (auto *w : {"b", "a", "c", "a"}) {
+      small.add(w, 1);
+    }
+    std::string keys;
+    small.merge([&](std::string_view key, int) { keys += key; });
+    expect(small.run_count() == 0_u);
+    expect(keys == "abc");
+  };
+
+  "test build report"_test = [] {
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+
+    std::vector<std::pair<std::string_view, int>> pairs;
+    for (auto &w : words) {
+      pairs.emplace_back(w, static_cast<int>(w.size()));
+    }
+
+    DoubleArrayTrieBuilder<> builder;
+    builder.add_bulk(pairs);
+    builder.end_build();
+
+    std::stringstream ss;
+    auto report = builder.build_report();
+    builder.save(ss, DefaultSerializer{}, report);
+    builder.save(ss, DefaultSerializer{});
+    expect(builder.build_report().phases.size() == 4_u);
+
+    std::string phases;
+    for (auto &phase : report.phases) {
+      phases += phase.name + " ";
+    }
+    expect(phases == "dawg charmap states trim save ");
+
+    expect(report.n_units > report.n_free_units);
+    expect(report.fill_rate() > 0.9);
+    expect(report.n_probes >= report.n_placements);
+    expect(report.saved_bytes * 2 == ss.str().size());
+    expect(report.n_dawg_states > 0_u);
+
+    auto json = report.to_json();
+    expect(json.starts_with("{\"phases\": [{\"name\": \"dawg\""));
+    expect(json.find("\"n_units\": " + std::to_string(report.n_units)) !=
+           std::string::npos);
+  };
+
   add_common_tests<DoubleArrayTrieBuilder<>, NoValueSerializer>();
   add_common_tests<DoubleArrayTrieBuilder<>, DefaultSerializer>(true);
 
   add_common_tests<DoubleArrayTrieBuilder<uint32_t, 0, true>,
                    CompactSerializer>(true);
 
+  add_common_tests<DoubleArrayTrieBuilder<int, -1, false, Utf8Alphabet>,
+                   WideSerializer>(true);
+
   return 0;
 }
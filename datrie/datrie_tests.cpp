@@ -1,15 +1,180 @@
+#include "any_trie.h"
+#include "blob_datrie.h"
+#include "blob_datrie_builder.h"
 #include "compact_datrie.h"
+#include "dawg_datrie_builder.h"
 #include "datrie_builder.h"
 #include "default_datrie.h"
+#include "huge_page_allocator.h"
 #include "no_value_datrie.h"
+#include "packed_datrie.h"
+#include "posting_datrie.h"
+#include "posting_datrie_builder.h"
 #include "serializers/compact_serializer.h"
 #include "serializers/default_serializer.h"
 #include "serializers/no_value_serializer.h"
+#include "serializers/packed_serializer.h"
+#include "serializers/wide_serializer.h"
+#include "static_datrie.h"
+#include "utf8_datrie.h"
 #include <boost/ut.hpp>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <levenshtein.h>
+#include <list>
+#include <loader.h>
+#include <pattern.h>
 #include <profile.h>
+#include <random>
+#include <sstream>
 #include <testcases.h>
+#include <thread>
+#include <unordered_map>
+#include <workload.h>
+
+template <typename Alphabet, typename Serializer>
+static void print_alphabet_metrics(const char *name,
+                                   const std::vector<std::string> &words) {
+  using namespace xtrie;
+
+  DoubleArrayTrieBuilder<int, -1, false, Alphabet> builder;
+  size_t n_trans = 0;
+  for (auto &w : words) {
+    builder.add(w, 1);
+
+    uint32_t len;
+    for (size_t i = 0; i < w.size(); i += len, ++n_trans) {
+      Alphabet::decode(w, i, len);
+    }
+  }
+  builder.end_build();
+
+  std::ostringstream os;
+  builder.save(os, Serializer{});
+
+  printf("\t%s: %.3f transitions/word, %zd bytes\n", name,
+         words.empty() ? 0.0 : static_cast<double>(n_trans) / words.size(),
+         os.str().size());
+}
+
+//! Fully associative LRU cache of 64-byte lines, counts the misses
+class CacheSimulator {
+public:
+  CacheSimulator(size_t n_lines) : n_lines_(n_lines) {}
+
+  void touch(size_t address) {
+    size_t line = address / 64;
+    auto it = index_.find(line);
+    if (it != index_.end()) {
+      lines_.splice(lines_.begin(), lines_, it->second);
+      return;
+    }
+
+    ++misses_;
+    lines_.push_front(line);
+    index_[line] = lines_.begin();
+    if (lines_.size() > n_lines_) {
+      index_.erase(lines_.back());
+      lines_.pop_back();
+    }
+  }
+
+  size_t misses() const { return misses_; }
+
+private:
+  size_t n_lines_;
+  size_t misses_ = 0;
+  std::list<size_t> lines_;
+  std::unordered_map<size_t, std::list<size_t>::iterator> index_;
+};
+
+//! per lookup, from a cache simulation of the units touched
+struct ReplayMetrics {
+  double lines;
+  double l1_misses;
+  double l2_misses;
+};
+
+template <typename Builder>
+static ReplayMetrics
+print_replay_metrics(const char *name, const Builder &builder,
+                     const std::vector<std::string> &queries) {
+  constexpr size_t unit_size = Builder::alphabet_type::UNIT_SIZE;
+
+  CacheSimulator l1(32 * 1024 / 64);
+  CacheSimulator l2(1024 * 1024 / 64);
+  size_t lines = 0;
+
+  for (auto &q : queries) {
+    int64_t p = 0;
+    size_t last_line = SIZE_MAX;
+    for (size_t i = 0; i < q.size(); ++i) {
+      p = builder.traverse(std::string_view(q).substr(i, 1), p).state();
+
+      l1.touch(p * unit_size);
+      l2.touch(p * unit_size);
+      if (p * unit_size / 64 != last_line) {
+        last_line = p * unit_size / 64;
+        ++lines;
+      }
+    }
+  }
+
+  double n = queries.empty() ? 1.0 : static_cast<double>(queries.size());
+  ReplayMetrics res{lines / n, l1.misses() / n, l2.misses() / n};
+  printf("\t%s: %.3f lines/lookup, simulated misses/lookup: L1 %.3f, "
+         "L2 %.3f\n",
+         name, res.lines, res.l1_misses, res.l2_misses);
+  return res;
+}
+
+template <typename Builder, typename Serializer>
+static void save_for_any_trie(const std::vector<std::string> &words,
+                              std::stringstream &ss) {
+  Builder builder;
+  for (size_t i = 0; i < words.size(); ++i) {
+    builder.add(words[i], static_cast<typename Builder::value_type>(i + 1));
+  }
+  builder.end_build();
+  if constexpr (std::is_void_v<Serializer>) {
+    builder.save(ss);
+  } else {
+    builder.save(ss, Serializer{});
+  }
+}
+
+// the English stop words of NLTK
+static constexpr std::string_view STOP_WORDS[] = {
+    "i",          "me",         "my",         "myself",     "we",
+    "our",        "ours",       "ourselves",  "you",        "your",
+    "yours",      "yourself",   "yourselves", "he",         "him",
+    "his",        "himself",    "she",        "her",        "hers",
+    "herself",    "it",         "its",        "itself",     "they",
+    "them",       "their",      "theirs",     "themselves", "what",
+    "which",      "who",        "whom",       "this",       "that",
+    "these",      "those",      "am",         "is",         "are",
+    "was",        "were",       "be",         "been",       "being",
+    "have",       "has",        "had",        "having",     "do",
+    "does",       "did",        "doing",      "a",          "an",
+    "the",        "and",        "but",        "if",         "or",
+    "because",    "as",         "until",      "while",      "of",
+    "at",         "by",         "for",        "with",       "about",
+    "against",    "between",    "into",       "through",    "during",
+    "before",     "after",      "above",      "below",      "to",
+    "from",       "up",         "down",       "in",         "out",
+    "on",         "off",        "over",       "under",      "again",
+    "further",    "then",       "once",       "here",       "there",
+    "when",       "where",      "why",        "how",        "all",
+    "any",        "both",       "each",       "few",        "more",
+    "most",       "other",      "some",       "such",       "no",
+    "nor",        "not",        "only",       "own",        "same",
+    "so",         "than",       "too",        "very",       "s",
+    "t",          "can",        "will",       "just",       "don",
+    "should",     "now"};
+
+static constexpr std::pair<std::string_view, int> UNITS[] = {
+    {"k", 1000}, {"m", 1000000}, {"\xE4\xB8\x87", 10000}, {"", 1}};
 
 int main() {
   using namespace boost::ut;
@@ -27,4 +192,879 @@ int main() {
   add_common_serializable_trie_tests<CompactDoubleArrayTrie<>,
                                      DoubleArrayTrieBuilder<uint32_t, 0, true>,
                                      CompactSerializer>(true);
+
+  add_common_serializable_trie_tests<
+      Utf8DoubleArrayTrie<>,
+      DoubleArrayTrieBuilder<int, -1, false, Utf8Alphabet>, WideSerializer>(
+      true);
+
+  "test any trie"_test = [] {
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    std::sort(words.begin(), words.end());
+
+    std::stringstream no_value_ss, default_ss, compact_ss, wide_ss, dawg_ss,
+        packed_ss;
+    save_for_any_trie<DoubleArrayTrieBuilder<>, NoValueSerializer>(
+        words, no_value_ss);
+    save_for_any_trie<DoubleArrayTrieBuilder<>, DefaultSerializer>(
+        words, default_ss);
+    save_for_any_trie<DoubleArrayTrieBuilder<uint32_t, 0, true>,
+                      CompactSerializer>(words, compact_ss);
+    save_for_any_trie<DoubleArrayTrieBuilder<int, -1, false, Utf8Alphabet>,
+                      WideSerializer>(words, wide_ss);
+    save_for_any_trie<DawgDoubleArrayTrieBuilder<>, void>(words, dawg_ss);
+    save_for_any_trie<DoubleArrayTrieBuilder<>, PackedSerializer<>>(
+        words, packed_ss);
+
+    std::vector<std::string_view> keys(words.begin(), words.end());
+    keys.push_back("nbysst");
+
+    for (auto [ss, format] :
+         {std::pair{&no_value_ss, TrieFormat::NO_VALUE},
+          std::pair{&default_ss, TrieFormat::DEFAULT},
+          std::pair{&compact_ss, TrieFormat::COMPACT},
+          std::pair{&wide_ss, TrieFormat::WIDE},
+          std::pair{&dawg_ss, TrieFormat::DAWG},
+          std::pair{&packed_ss, TrieFormat::PACKED}}) {
+      AnyTrie trie;
+      expect(trie.load(*ss));
+      expect(trie.format() == format);
+
+      auto values = trie.lookup(keys);
+      bool all_found = true;
+      for (size_t i = 0; i < words.size(); ++i) {
+        auto v = trie.lookup(words[i]);
+        all_found &= v.has_value() && values[i] == v &&
+                     (!trie.has_values() || *v == static_cast<int64_t>(i + 1));
+      }
+      expect(all_found);
+      expect(!values.back().has_value());
+
+      // "A.", "A.B." and "A.B.A." are keys
+      std::vector<size_t> lengths;
+      trie.common_prefix_search(
+          "A.B.A.s", [&](size_t len, int64_t) { lengths.push_back(len); });
+      expect(lengths == std::vector<size_t>{2, 4, 6});
+    }
+
+    // files without the header can't be told apart
+    std::stringstream legacy;
+    legacy.write(no_value_ss.str().data() + 2 * sizeof(uint32_t),
+                 no_value_ss.str().size() - 2 * sizeof(uint32_t));
+
+    AnyTrie trie;
+    expect(!trie.load(legacy));
+    expect(!trie.lookup("A.B.A.").has_value());
+
+    NoValueDoubleArrayTrie<> no_value_trie;
+    legacy.seekg(0);
+    no_value_trie.load(legacy);
+    auto res = no_value_trie.traverse("A.B.A.");
+    expect(res.matched() && no_value_trie.has_value_at(res.state()));
+  };
+
+  "test dawg double array trie"_test = [] {
+    for (auto filename : {"en_1k.txt", "en_466k.txt", "zh_cn_406k.txt"}) {
+      auto words = load_lexicon((std::string(DATA_DIR) + filename).c_str());
+      std::sort(words.begin(), words.end());
+      words.erase(std::unique(words.begin(), words.end()), words.end());
+      if (words.empty())
+        continue;
+
+      std::stringstream dawg_ss, default_ss;
+      save_for_any_trie<DawgDoubleArrayTrieBuilder<>, void>(words, dawg_ss);
+      save_for_any_trie<DoubleArrayTrieBuilder<>, DefaultSerializer>(
+          words, default_ss);
+
+      DawgDoubleArrayTrie<> trie;
+      trie.load(dawg_ss);
+      expect(trie.size() == words.size());
+
+      bool all_found = true;
+      for (size_t i = 0; i < words.size(); ++i) {
+        auto res = trie.traverse(words[i]);
+        all_found &= res.matched() && trie.has_value_at(res.state()) &&
+                     trie.value_at(res.state()) == static_cast<int>(i + 1);
+
+        // a proper prefix is a key only if it is the previous word
+        auto prefix = std::string_view(words[i]).substr(0, words[i].size() / 2);
+        res = trie.traverse(prefix);
+        bool is_key = std::binary_search(words.begin(), words.end(), prefix);
+        bool found = res.matched() && trie.has_value_at(res.state());
+        all_found &= found == is_key;
+      }
+      expect(all_found);
+      expect(!trie.traverse(words.back() + "\x01").matched());
+
+      // a walk of the children lists the keys in order, with their rank
+      std::vector<std::string> keys;
+      std::string key;
+      bool ranked = true;
+      auto walk = [&](auto &self, DawgDoubleArrayTrie<>::State state) -> void {
+        if (trie.has_value_at(state)) {
+          ranked &= state.rank == keys.size();
+          keys.push_back(key);
+        }
+        trie.for_each_child(state, [&](char ch, auto child) {
+          key.push_back(ch);
+          self(self, child);
+          key.pop_back();
+        });
+      };
+      walk(walk, trie.traverse("").state());
+      expect(keys == words);
+      expect(ranked);
+
+      std::cout << filename << ": dawg " << dawg_ss.str().size()
+                << " bytes, tree " << default_ss.str().size() << " bytes"
+                << std::endl;
+    }
+  };
+
+  "test packed units"_test = [] {
+    for (auto filename : {"en_1k.txt", "en_466k.txt", "zh_cn_406k.txt"}) {
+      auto words = load_lexicon((std::string(DATA_DIR) + filename).c_str());
+      std::sort(words.begin(), words.end());
+      if (words.empty())
+        continue;
+
+      std::stringstream default_ss, packed_ss, packed256_ss;
+      save_for_any_trie<DoubleArrayTrieBuilder<>, DefaultSerializer>(
+          words, default_ss);
+      save_for_any_trie<DoubleArrayTrieBuilder<>, PackedSerializer<>>(
+          words, packed_ss);
+      save_for_any_trie<DoubleArrayTrieBuilder<>, PackedSerializer<256>>(
+          words, packed256_ss);
+
+      DefaultDoubleArrayTrie<> expected;
+      expected.load(default_ss);
+      PackedDoubleArrayTrie<> packed, packed256;
+      packed.load(packed_ss);
+      packed256.load(packed256_ss);
+      expect(packed.n_units() == expected.n_units());
+
+      // same states for the keys, their prefixes and the misses
+      bool same = true;
+      for (auto *trie : {&packed, &packed256}) {
+        for (auto &word : words) {
+          for (auto query : {word, word.substr(0, word.size() / 2),
+                             word + "\x01", "#" + word}) {
+            auto a = expected.traverse(query);
+            auto b = trie->traverse(query);
+            same &= a.matched() == b.matched() &&
+                    a.matched_length() == b.matched_length() &&
+                    a.state() == b.state() &&
+                    expected.has_value_at(a.state()) ==
+                        trie->has_value_at(b.state()) &&
+                    expected.value_at(a.state()) == trie->value_at(b.state());
+          }
+        }
+      }
+      expect(same);
+
+      std::cout << filename << ": units " << 4 * expected.n_units()
+                << " bytes, packed by 64 " << packed.units_size()
+                << ", by 256 " << packed256.units_size() << std::endl;
+    }
+
+    // 8-byte values, the size measured before packing is the size written
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    constexpr int64_t wide_base = int64_t(1) << 40;
+    DoubleArrayTrieBuilder<int64_t, -1> builder;
+    for (size_t i = 0; i < words.size(); ++i) {
+      builder.add(words[i], wide_base + static_cast<int64_t>(i));
+    }
+    builder.end_build();
+
+    std::stringstream wide;
+    size_t size_sum = builder.save(wide, PackedSerializer<>{});
+    size_t n_units = builder.build_report().n_units;
+    expect(wide.str().size() ==
+           3 * sizeof(uint32_t) + size_sum + sizeof(int64_t) * n_units);
+
+    AnyTrie any;
+    expect(any.load(wide));
+    expect(any.format() == TrieFormat::PACKED64);
+    expect(any.lookup(words.back()) ==
+           wide_base + static_cast<int64_t>(words.size() - 1));
+
+    wide.seekg(0);
+    PackedDoubleArrayTrie<> narrow;
+    expect(throws<std::invalid_argument>([&] { narrow.load(wide); }));
+  };
+
+  "test blob values"_test = [] {
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    expect(words.size() > 100_u);
+
+    // a few tags shared by most keys, and long values, whose length takes
+    // two bytes, of their own
+    const std::string tags[] = {"n", "v", "adj", "{\"pos\": \"adv\"}"};
+    auto blob_of = [&](size_t i) {
+      if (i % 100 == 0) {
+        std::string res;
+        while (res.size() < 200)
+          res += words[i];
+        return res;
+      }
+      return tags[i % 4];
+    };
+
+    std::vector<std::pair<std::string, std::string>> pairs;
+    for (size_t i = 0; i < words.size(); ++i) {
+      pairs.push_back({words[i], blob_of(i)});
+    }
+    // a key given again keeps its first blob, even an empty one, and the
+    // blobs it is given again don't go into the pool
+    std::string no_blob = words.back() + "~";
+    pairs.push_back({no_blob, ""});
+    pairs.push_back({words[0], "again"});
+    pairs.push_back({no_blob, "again"});
+
+    BlobDoubleArrayTrieBuilder builder;
+    builder.add_bulk(pairs);
+    builder.end_build();
+    expect(builder.n_blobs() == 4 + (words.size() + 99) / 100);
+
+    std::string path = DATA_DIR "en_1k.txt.blob";
+    std::stringstream ss;
+    {
+      std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+      builder.save(ofs);
+      expect(builder.save(ss) == ss.str().size());
+    }
+
+    // the size is counted for streams without tellp too
+    struct {
+      size_t n_bytes = 0;
+      void write(const char *, std::streamsize n) { n_bytes += n; }
+    } sink;
+    expect(builder.save(sink) == ss.str().size());
+
+    BlobDoubleArrayTrie<> loaded, mapped;
+    loaded.load(ss);
+    expect(mapped.map(path.c_str()));
+
+    bool all_found = true;
+    for (auto *trie : {&loaded, &mapped}) {
+      for (size_t i = 0; i < words.size(); ++i) {
+        auto res = trie->traverse(words[i]);
+        all_found &= res.matched() && trie->has_value_at(res.state()) &&
+                     trie->value_at(res.state()).compare(blob_of(i)) == 0;
+      }
+      auto res = trie->traverse("");
+      all_found &= !trie->has_value_at(res.state()) &&
+                   trie->value_at(res.state()).empty();
+      res = trie->traverse(no_blob);
+      all_found &= !res.matched() || !trie->has_value_at(res.state());
+    }
+    expect(all_found);
+
+    // the values of the mapped trie are views into the file
+    auto value = mapped.value_at(mapped.traverse(words[1]).state());
+    auto &pool = mapped.pool();
+    expect(value.data() > pool.data() &&
+           value.data() < pool.data() + pool.size());
+    std::remove(path.c_str());
+  };
+
+  "test posting lists"_test = [] {
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    expect(words.size() > 100_u);
+
+    // short lists, long ones of several blocks and sparse ones whose
+    // deltas take up to 32 bits
+    std::mt19937 rng(42);
+    std::vector<std::pair<std::string, std::vector<uint32_t>>> index;
+    size_t n_ids = 0;
+    for (size_t i = 0; i < words.size(); ++i) {
+      size_t n = i % 100 == 0 ? 1000 + rng() % 5000 : 1 + rng() % 20;
+      uint32_t max_id = i % 7 == 0 ? UINT32_MAX : 1000000;
+
+      std::vector<uint32_t> doc_ids;
+      for (size_t j = 0; j < n; ++j) {
+        doc_ids.push_back(static_cast<uint32_t>(rng() % max_id));
+      }
+      if (i % 13 == 0)
+        doc_ids.push_back(UINT32_MAX);
+      std::sort(doc_ids.begin(), doc_ids.end());
+      doc_ids.erase(std::unique(doc_ids.begin(), doc_ids.end()),
+                    doc_ids.end());
+      n_ids += doc_ids.size();
+      index.push_back({words[i], std::move(doc_ids)});
+    }
+
+    PostingDoubleArrayTrieBuilder builder;
+    builder.add_bulk(index);
+    builder.end_build();
+
+    std::string path = DATA_DIR "en_1k.txt.postings";
+    {
+      std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+      builder.save(ofs);
+    }
+    PostingDoubleArrayTrie<> trie;
+    expect(trie.map(path.c_str()));
+
+    bool all_equal = true;
+    for (auto &[term, doc_ids] : index) {
+      auto list = trie.postings(term);
+      all_equal &= list.size() == doc_ids.size() &&
+                   std::ranges::equal(list, doc_ids);
+
+      // advance to increasing targets, some past the end of the list
+      auto cursor = list.cursor();
+      uint64_t target = 0;
+      for (int k = 0; k < 8 && !cursor.done(); ++k) {
+        target += rng() % (doc_ids.back() / 4 + 2);
+        if (target > UINT32_MAX)
+          break;
+        cursor.advance(static_cast<uint32_t>(target));
+        auto it = std::lower_bound(doc_ids.begin(), doc_ids.end(), target);
+        all_equal &= it == doc_ids.end()
+                         ? cursor.done()
+                         : !cursor.done() && cursor.doc() == *it;
+      }
+    }
+    expect(all_equal);
+    expect(trie.postings(words[0] + "\x01").empty());
+
+    std::cout << "postings: " << n_ids << " ids, " << trie.pool().size()
+              << " bytes encoded, " << 4 * n_ids << " bytes as uint32_t"
+              << std::endl;
+    std::remove(path.c_str());
+  };
+
+  "test fuzzy search"_test = [] {
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    std::sort(words.begin(), words.end());
+
+    std::stringstream no_value_ss, default_ss, compact_ss;
+    save_for_any_trie<DoubleArrayTrieBuilder<>, NoValueSerializer>(
+        words, no_value_ss);
+    save_for_any_trie<DoubleArrayTrieBuilder<>, DefaultSerializer>(
+        words, default_ss);
+    save_for_any_trie<DoubleArrayTrieBuilder<uint32_t, 0, true>,
+                      CompactSerializer>(words, compact_ss);
+
+    NoValueDoubleArrayTrie<> no_value_trie;
+    DefaultDoubleArrayTrie<> default_trie;
+    CompactDoubleArrayTrie<> compact_trie;
+    no_value_trie.load(no_value_ss);
+    default_trie.load(default_ss);
+    compact_trie.load(compact_ss);
+
+    auto queries = typo_queries(words, 100, 2);
+    queries.push_back("");
+    queries.push_back(words[0]);
+
+    using match_type = std::pair<std::string, uint32_t>;
+
+    bool all_equal = true;
+    for (uint32_t k = 0; k <= 2; ++k) {
+      for (auto &q : queries) {
+        LevenshteinAutomaton automaton(q, k);
+        std::vector<match_type> expected;
+        for (auto &w : words) {
+          if (auto d = automaton.distance_to(w); d <= k)
+            expected.push_back({w, d});
+        }
+
+        auto search = [&](const auto &trie) {
+          std::vector<match_type> res;
+          trie.fuzzy_search(q, k, [&](std::string_view key, unsigned state,
+                                      uint32_t d) {
+            res.push_back({std::string(key), d});
+            all_equal &= trie.has_value_at(state);
+          });
+          return res;
+        };
+
+        all_equal &= search(no_value_trie) == expected &&
+                     search(default_trie) == expected &&
+                     search(compact_trie) == expected;
+      }
+    }
+    expect(all_equal);
+
+    std::vector<std::string> found;
+    default_trie.fuzzy_search("10-poin", 1, [&](std::string_view key,
+                                                unsigned state, uint32_t d) {
+      found.emplace_back(key);
+      auto it = std::lower_bound(words.begin(), words.end(), key);
+      all_equal &= d == 1 && default_trie.value_at(state) ==
+                                 it - words.begin() + 1;
+    });
+    expect(all_equal);
+    expect(found == std::vector<std::string>{"10-point"});
+  };
+
+  "test pattern match"_test = [] {
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    std::sort(words.begin(), words.end());
+
+    std::stringstream default_ss, compact_ss;
+    save_for_any_trie<DoubleArrayTrieBuilder<>, DefaultSerializer>(
+        words, default_ss);
+    save_for_any_trie<DoubleArrayTrieBuilder<uint32_t, 0, true>,
+                      CompactSerializer>(words, compact_ss);
+
+    DefaultDoubleArrayTrie<> default_trie;
+    CompactDoubleArrayTrie<> compact_trie;
+    default_trie.load(default_ss);
+    compact_trie.load(compact_ss);
+
+    std::vector<PatternDfa> dfas;
+    for (auto *glob : {"1?-point", "*-point", "A.*", "*", "", "?", "a*b*c"}) {
+      auto dfa = PatternDfa::glob(glob);
+      expect(dfa.has_value());
+      dfas.push_back(std::move(*dfa));
+    }
+    for (auto *re : {"[0-9]+(st|nd|rd|th)", "[^a-z]*", "(ab|a)c?.?", "\\.*",
+                     "A\\.(B\\.)*"}) {
+      auto dfa = PatternDfa::regex(re);
+      expect(dfa.has_value());
+      dfas.push_back(std::move(*dfa));
+    }
+
+    bool all_equal = true;
+    for (auto &dfa : dfas) {
+      std::vector<std::string> expected;
+      std::copy_if(words.begin(), words.end(), std::back_inserter(expected),
+                   [&](const std::string &w) { return dfa.matches(w); });
+
+      auto collect = [&](const auto &trie) {
+        std::vector<std::string> res;
+        for (auto &m : match_pattern(trie, dfa)) {
+          res.emplace_back(m.key);
+          all_equal &= trie.has_value_at(m.state);
+        }
+        return res;
+      };
+      all_equal &= collect(default_trie) == expected &&
+                   collect(compact_trie) == expected;
+    }
+    expect(all_equal);
+
+    // lazy, the first match comes without walking the rest
+    auto any = *PatternDfa::glob("*");
+    auto it = match_pattern(default_trie, any).begin();
+    expect(it != std::default_sentinel);
+    expect(it->key.compare(words[0]) == 0);
+
+    // the key of a match follows the iterator when it moves
+    std::optional<decltype(it)> moved;
+    {
+      auto first = match_pattern(default_trie, any).begin();
+      moved.emplace(std::move(first));
+    }
+    expect((*moved)->key.compare(words[0]) == 0);
+
+    for (auto *bad : {"(a", "a)", "*a", "[a-", "[z-a]", "a\\"}) {
+      expect(!PatternDfa::regex(bad).has_value());
+    }
+    // a star followed by n '?' takes 2^n states
+    expect(!PatternDfa::glob("*a" + std::string(14, '?')).has_value());
+    expect(PatternDfa::glob("*a" + std::string(8, '?'), 1024).has_value());
+  };
+
+  "test restore key"_test = [] {
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    std::stringstream no_value_ss, default_ss, compact_ss;
+    save_for_any_trie<DoubleArrayTrieBuilder<>, NoValueSerializer>(
+        words, no_value_ss);
+    save_for_any_trie<DoubleArrayTrieBuilder<>, DefaultSerializer>(
+        words, default_ss);
+    save_for_any_trie<DoubleArrayTrieBuilder<uint32_t, 0, true>,
+                      CompactSerializer>(words, compact_ss);
+
+    NoValueDoubleArrayTrie<> no_value_trie;
+    DefaultDoubleArrayTrie<> default_trie;
+    CompactDoubleArrayTrie<> compact_trie;
+    no_value_trie.load(no_value_ss);
+    default_trie.load(default_ss);
+    compact_trie.load(compact_ss);
+
+    bool all_restored = true;
+    auto check = [&](auto &trie) {
+      trie.build_key_index();
+      all_restored &= trie.key_index().size() == words.size();
+
+      char buf[256];
+      for (size_t i = 0; i < words.size(); ++i) {
+        auto res = trie.traverse(words[i]);
+        size_t n = trie.restore_key(res.state(), buf, sizeof(buf));
+        all_restored &= words[i].compare(std::string_view(buf, n)) == 0;
+        all_restored &= trie.key_state(i) == res.state();
+        all_restored &= trie.key_ordinal(res.state()) == i;
+      }
+
+      // a prefix state has a key too, a short buffer is left alone
+      auto res = trie.traverse("10-poin");
+      all_restored &= trie.restore_key(res.state(), buf, 3) == 7;
+      all_restored &= trie.restore_key(0, buf, 0) == 0;
+    };
+    check(no_value_trie);
+    check(default_trie);
+    check(compact_trie);
+    expect(all_restored);
+  };
+
+  "test key range"_test = [] {
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    std::stringstream default_ss, ordered_ss, compact_ss;
+    save_for_any_trie<DoubleArrayTrieBuilder<>, DefaultSerializer>(
+        words, default_ss);
+    save_for_any_trie<
+        DoubleArrayTrieBuilder<int, -1, false, OrderedByteAlphabet>,
+        DefaultSerializer>(words, ordered_ss);
+    save_for_any_trie<DoubleArrayTrieBuilder<uint32_t, 0, true>,
+                      CompactSerializer>(words, compact_ss);
+
+    DefaultDoubleArrayTrie<> default_trie, ordered_trie;
+    CompactDoubleArrayTrie<> compact_trie;
+    default_trie.load(default_ss);
+    ordered_trie.load(ordered_ss);
+    compact_trie.load(compact_ss);
+
+    std::vector<std::pair<std::string, std::string>> bounds{
+        {"", ""},        {"", "\xff"},       {"10", "2"},   {"A", "B"},
+        {"A.B.", "A.C"}, {"10-poin", "11"}, {"zz", "zzz"}, {"b", "a"},
+        {"\xff", ""}};
+    for (size_t i = 0; i + 1 < words.size(); i += 97) {
+      bounds.push_back({words[i], words[i + 1]});
+      bounds.push_back({words[i] + '\x01', words[i + 1] + '\x01'});
+      bounds.push_back({words[i].substr(0, words[i].size() / 2), words[i]});
+    }
+
+    bool all_equal = true;
+    for (auto &[lo, hi] : bounds) {
+      auto first = std::lower_bound(words.begin(), words.end(), lo);
+      auto last = std::max(first, std::lower_bound(words.begin(),
+                                                   words.end(), hi));
+      std::vector<std::string> expected(first, last);
+
+      auto collect = [&](const auto &trie) {
+        std::vector<std::string> res;
+        for (auto &e : trie.range(lo, hi)) {
+          res.emplace_back(e.key);
+          all_equal &= trie.has_value_at(e.state);
+        }
+        return res;
+      };
+      all_equal &= collect(default_trie) == expected &&
+                   collect(ordered_trie) == expected &&
+                   collect(compact_trie) == expected;
+
+      auto it = compact_trie.lower_bound(lo);
+      if (first == words.end()) {
+        all_equal &= it == std::default_sentinel;
+      } else {
+        all_equal &= it != std::default_sentinel &&
+                     it->key.compare(*first) == 0 &&
+                     compact_trie.value_at(it->state) ==
+                         static_cast<uint32_t>(first - words.begin() + 1);
+      }
+    }
+    expect(all_equal);
+
+    // the key of an entry follows the iterator when it moves, e.g. into a
+    // ranges algorithm
+    std::optional<decltype(key_range(default_trie, "a", "z").begin())> moved;
+    {
+      auto first = key_range(default_trie, "a", "z").begin();
+      moved.emplace(std::move(first));
+    }
+    auto first = std::lower_bound(words.begin(), words.end(), "a");
+    expect((*moved)->key.compare(*first) == 0);
+  };
+
+  "test huge page allocator"_test = [] {
+    using Allocator = HugePageAllocator<uint32_t>;
+
+    // 4 MB, on huge pages, and a small one through std::allocator
+    std::vector<uint32_t, Allocator> big(1 << 20, 7), small(16, 7);
+    expect(reinterpret_cast<uintptr_t>(big.data()) %
+               Allocator::HUGE_PAGE_SIZE ==
+           0_u);
+    expect(big.back() == 7_u);
+    expect(small.back() == 7_u);
+
+    // every key of 3 chars out of 64, whose units are over the 1 MB from
+    // which huge pages are used
+    std::vector<std::string> words;
+    for (int a = 0; a < 64; ++a) {
+      for (int b = 0; b < 64; ++b) {
+        for (int c = 0; c < 64; ++c) {
+          words.push_back({char('0' + a), char('0' + b), char('0' + c)});
+        }
+      }
+    }
+
+    std::stringstream ss;
+    save_for_any_trie<DoubleArrayTrieBuilder<>, DefaultSerializer>(words, ss);
+
+    DefaultDoubleArrayTrie<int, -1, NoAccessProfile, HugePageAllocator> trie;
+    trie.load(ss);
+    expect(trie.n_units() * sizeof(int32_t) >= Allocator::HUGE_PAGE_SIZE / 2);
+
+    bool all_found = true;
+    for (size_t i = 0; i < words.size(); ++i) {
+      auto res = trie.traverse(words[i]);
+      all_found &= res.matched() &&
+                   trie.value_at(res.state()) == static_cast<int>(i + 1);
+    }
+    expect(all_found);
+  };
+
+  "test value layouts"_test = [] {
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    auto check = [&](auto &trie, auto base_value) {
+      using value_type =
+          typename std::remove_cvref_t<decltype(trie)>::value_type;
+
+      bool all_found = true;
+      for (size_t i = 0; i < words.size(); ++i) {
+        auto res = trie.traverse(words[i]);
+        all_found &= res.matched() &&
+                     trie.value_at(res.state()) ==
+                         static_cast<value_type>(base_value + i);
+      }
+      expect(all_found);
+      expect(!trie.has_value_at(trie.traverse("A").state()));
+    };
+
+    std::stringstream narrow;
+    {
+      DoubleArrayTrieBuilder<> builder;
+      for (size_t i = 0; i < words.size(); ++i) {
+        builder.add(words[i], static_cast<int>(i));
+      }
+      builder.end_build();
+      builder.save(narrow, DefaultSerializer{});
+    }
+
+    DefaultDoubleArrayTrie<> split;
+    DefaultDoubleArrayTrie<int, -1, NoAccessProfile, std::allocator,
+                           InterleavedLayout>
+        interleaved;
+    split.load(narrow);
+    narrow.seekg(0);
+    interleaved.load(narrow);
+    check(split, 0);
+    check(interleaved, 0);
+
+    // values past 32 bits, in 16-byte records
+    constexpr int64_t wide_base = int64_t(1) << 40;
+    std::stringstream wide;
+    {
+      DoubleArrayTrieBuilder<int64_t, -1> builder;
+      for (size_t i = 0; i < words.size(); ++i) {
+        builder.add(words[i], wide_base + static_cast<int64_t>(i));
+      }
+      builder.end_build();
+      builder.save(wide, DefaultSerializer{});
+    }
+
+    DefaultDoubleArrayTrie<int64_t, -1> wide_split;
+    DefaultDoubleArrayTrie<int64_t, -1, NoAccessProfile, std::allocator,
+                           InterleavedLayout>
+        wide_interleaved;
+    wide_split.load(wide);
+    wide.seekg(0);
+    wide_interleaved.load(wide);
+    check(wide_split, wide_base);
+    check(wide_interleaved, wide_base);
+
+    // the value size is in the format, neither side misreads the other
+    wide.seekg(0);
+    AnyTrie any;
+    expect(any.load(wide));
+    expect(any.format() == TrieFormat::DEFAULT64);
+    expect(any.lookup(words.back()) ==
+           wide_base + static_cast<int64_t>(words.size() - 1));
+
+    wide.seekg(0);
+    narrow.seekg(0);
+    expect(throws<std::invalid_argument>([&] { split.load(wide); }));
+    expect(throws<std::invalid_argument>([&] { wide_split.load(narrow); }));
+  };
+
+  "test static trie"_test = [] {
+    static constexpr auto stop_words = make_static_trie<STOP_WORDS>();
+    static_assert(stop_words.contains("the"));
+    static_assert(stop_words.find("ourselves") == 7);
+    static_assert(!stop_words.contains("th"));
+    static_assert(!stop_words.contains("thee"));
+    static_assert(!stop_words.contains(""));
+    static_assert(stop_words.traverse("themselve").matched());
+
+    bool all_found = true;
+    for (size_t i = 0; i < std::size(STOP_WORDS); ++i) {
+      all_found &= stop_words.find(STOP_WORDS[i]) == static_cast<int>(i);
+
+      // every proper prefix which is not a stop word itself misses
+      for (size_t n = 0; n < STOP_WORDS[i].size(); ++n) {
+        auto prefix = STOP_WORDS[i].substr(0, n);
+        all_found &= stop_words.contains(prefix) ==
+                     (std::find(std::begin(STOP_WORDS), std::end(STOP_WORDS),
+                                prefix) != std::end(STOP_WORDS));
+      }
+    }
+    expect(all_found);
+
+    static constexpr auto units = make_static_trie<UNITS>();
+    static_assert(units.find("") == 1);
+    static_assert(units.find("m") == 1000000);
+    static_assert(units.find("\xE4\xB8\x87") == 10000);
+    static_assert(!units.contains("\xE4\xB8"));
+    static_assert(!units.contains("km"));
+    static_assert(IsKVTrie<decltype(units)>);
+  };
+
+  "test access profile"_test = [] {
+    static_assert(sizeof(DefaultDoubleArrayTrie<>) ==
+                  sizeof(DefaultDoubleArrayTrie<int, -1, NoAccessProfile>));
+
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    std::sort(words.begin(), words.end());
+
+    DoubleArrayTrieBuilder builder;
+    for (size_t i = 0; i < words.size(); ++i) {
+      builder.add(words[i], static_cast<int>(i));
+    }
+    builder.end_build();
+
+    std::stringstream ss;
+    builder.save(ss, DefaultSerializer{});
+
+    DefaultDoubleArrayTrie<int, -1, AccessProfile> trie;
+    trie.load(ss);
+
+    auto queries = zipf_queries(words, 10000);
+    auto replay = [&] {
+      for (auto &q : queries) {
+        trie.traverse(q);
+      }
+    };
+
+    std::thread t0(replay), t1(replay);
+    t0.join();
+    t1.join();
+
+    auto stats = trie.profile().merge();
+    expect(stats.state_visits[0] == 2 * queries.size());
+    expect(stats.depth_hits[0] == 2 * queries.size());
+
+    // traverse is profiled too, look the state up before counting
+    auto hot = trie.traverse(queries.front()).state();
+    expect(stats.state_visits[hot] > 0_u);
+    expect(trie.profile().merge().state_visits[0] == 2 * queries.size() + 1);
+
+    // round trip through the text format, back into the builder
+    std::stringstream weights_ss;
+    AccessProfile::write_weights(weights_ss, trie.export_weights());
+    auto weights = AccessProfile::read_weights(weights_ss);
+
+    uint64_t total = 0;
+    for (auto &[prefix, weight] : weights) {
+      total += weight;
+    }
+    expect(total == 2 * queries.size() + 1);
+
+    DoubleArrayTrieBuilder weighted;
+    for (size_t i = 0; i < words.size(); ++i) {
+      weighted.add(words[i], static_cast<int>(i));
+    }
+    weighted.add_weights(weights);
+    weighted.end_build();
+
+    auto res = weighted.traverse(queries.front());
+    expect(res.matched() && weighted.has_value_at(res.state()));
+
+    // two profiled tries used in turn by one thread count apart
+    std::stringstream other_ss;
+    builder.save(other_ss, DefaultSerializer{});
+    DefaultDoubleArrayTrie<int, -1, AccessProfile> other;
+    other.load(other_ss);
+
+    uint64_t before = trie.profile().merge().state_visits[0];
+    for (int i = 0; i < 10; ++i) {
+      trie.traverse("");
+      other.traverse("");
+    }
+    expect(trie.profile().merge().state_visits[0] == before + 10);
+    expect(other.profile().merge().state_visits[0] == 10_u);
+  };
+
+  "test weighted placement"_test = [] {
+    for (auto filename : {"en_1k.txt", "en_466k.txt", "zh_cn_406k.txt"}) {
+      std::cout << filename << std::endl;
+
+      auto words = load_lexicon((std::string(DATA_DIR) + filename).c_str());
+      std::sort(words.begin(), words.end());
+
+      // the first half is the query log, the second half is replayed
+      auto queries = zipf_queries(words, 200000);
+      std::vector<std::string> log(queries.begin(),
+                                   queries.begin() + queries.size() / 2);
+      std::vector<std::string> replay(queries.begin() + queries.size() / 2,
+                                      queries.end());
+
+      DoubleArrayTrieBuilder plain;
+      DoubleArrayTrieBuilder weighted;
+      for (size_t i = 0; i < words.size(); ++i) {
+        plain.add(words[i], static_cast<int>(i));
+        weighted.add(words[i], static_cast<int>(i));
+      }
+      for (auto &q : log) {
+        weighted.add_weight(q, 1);
+      }
+      plain.end_build();
+      weighted.end_build();
+
+      bool all_found = true;
+      for (size_t i = 0; i < words.size(); ++i) {
+        auto res = weighted.traverse(words[i]);
+        all_found &= res.matched() &&
+                     weighted.value_at(res.state()) == static_cast<int>(i);
+      }
+      expect(all_found);
+
+      auto bfs = print_replay_metrics("bfs", plain, replay);
+      auto hot = print_replay_metrics("weighted", weighted, replay);
+      expect(hot.lines <= bfs.lines);
+      expect(hot.l1_misses <= bfs.l1_misses);
+    }
+  };
+
+  "test byte alphabets vs utf8 alphabet"_test = [] {
+    for (auto filename : {"en_1k.txt", "en_466k.txt", "zh_cn_406k.txt"}) {
+      std::cout << filename << std::endl;
+
+      auto words = load_lexicon((std::string(DATA_DIR) + filename).c_str());
+      std::sort(words.begin(), words.end());
+
+      print_alphabet_metrics<ByteAlphabet, DefaultSerializer>("byte", words);
+      print_alphabet_metrics<OrderedByteAlphabet, DefaultSerializer>(
+          "ordered byte", words);
+      print_alphabet_metrics<Utf8Alphabet, WideSerializer>("utf8", words);
+    }
+  };
 }
\ No newline at end of file
@@ -0,0 +1,177 @@
+#ifndef DAWG_DATRIE_H
+#define DAWG_DATRIE_H
+
+#include "serializers/format.h"
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef ASSERT_CONCEPT
+#include <trie_concepts.h>
+#endif
+
+namespace xtrie {
+
+//! @brief Unit of DawgDoubleArrayTrie: one transition
+//!
+//!     The unit at base + label of a node leads to the child of label. A
+//!     node shared by several parents is placed once, all their units hold
+//!     its base. Since the node has no single path from the root, its
+//!     units carry what the walk needs to know about the key instead of a
+//!     unit index: whether a key ends at the child, and the rank of the
+//!     child, the number of keys before it among the keys under the
+//!     parent. The ranks summed along a key give its rank in key order.
+struct DawgUnit {
+  static constexpr uint32_t MAX_BASE = (1u << 23) - 1;
+
+  uint32_t label : 8;    // mapped char, 0 if the unit is free
+  uint32_t terminal : 1; // a key ends at the child
+  uint32_t base : 23;    // block of the child, 0 if it has no children
+  uint32_t rank;
+};
+
+static_assert(sizeof(DawgUnit) == 2 * sizeof(uint32_t));
+
+//! @brief Double array trie over a minimal DAWG, see
+//! DawgDoubleArrayTrieBuilder
+//!
+//!     The double array of DoubleArrayTrieBuilder is a tree, every suffix
+//!     is stored once per prefix leading to it. Here the units are the
+//!     transitions of the DAWG, so a suffix shared by several keys is
+//!     stored once, and the values, which would keep the nodes apart, are
+//!     an array in key order indexed by the rank of the key.
+//!
+//!     A state is the base of a node plus the rank and the terminal flag of
+//!     the path walked to it.
+template <typename T = int, T DefaultValue = -1,
+          template <typename> class Allocator = std::allocator>
+class DawgDoubleArrayTrie {
+public:
+  using value_type = T;
+  static constexpr value_type DEFAULT_VALUE = DefaultValue;
+
+  struct State {
+    uint32_t base;
+    uint32_t rank;
+    bool terminal;
+
+    bool operator==(const State &) const = default;
+  };
+
+  class TraverseResult {
+    friend class DawgDoubleArrayTrie;
+
+  public:
+    State state() const { return state_; }
+    bool matched() const { return matched_; }
+    uint32_t matched_length() const { return matched_length_; }
+
+  private:
+    State state_;
+    bool matched_;
+    uint32_t matched_length_;
+
+    TraverseResult(State state, bool matched, uint32_t matched_length)
+        : state_(state), matched_(matched), matched_length_(matched_length) {}
+  };
+
+public:
+  template <typename IStream> void load(IStream &is) {
+    uint32_t size_sum;
+    [[maybe_unused]] auto format = read_format_header(is, size_sum);
+    assert(format == TrieFormat::DAWG);
+
+    // the header is 4 words, the first one was read as size_sum
+    uint32_t header[4] = {size_sum};
+    is.read(reinterpret_cast<char *>(header + 1), 3 * sizeof(uint32_t));
+    root_ = {header[2], 0, header[3] != 0};
+
+    is.read(reinterpret_cast<char *>(charmap_), sizeof(charmap_));
+    build_labels();
+
+    units_.resize(header[0]);
+    is.read(reinterpret_cast<char *>(units_.data()),
+            sizeof(DawgUnit) * units_.size());
+
+    values_.resize(header[1]);
+    is.read(reinterpret_cast<char *>(values_.data()),
+            sizeof(value_type) * values_.size());
+  }
+
+  TraverseResult traverse(std::string_view prefix, State state) const {
+    State p = state;
+
+    uint32_t i = 0;
+    for (; i < prefix.size(); ++i) {
+      uint32_t label = charmap_[static_cast<uint8_t>(prefix[i])];
+      uint32_t index = p.base + label;
+      if (label == 0 || index >= units_.size() || units_[index].label != label)
+        return {p, false, i};
+
+      auto unit = units_[index];
+      p = {unit.base, p.rank + unit.rank, unit.terminal != 0};
+    }
+    return {p, true, i};
+  }
+
+  TraverseResult traverse(std::string_view prefix) const {
+    return traverse(prefix, root_);
+  }
+
+  //! @brief Enumerate the transitions of a state
+  //!
+  //!     The children of a shared node are enumerated once per path to it,
+  //!     a walk from the root sees the trie of the keys, not the DAWG.
+  //!
+  //! @param f called as f(char, child state)
+  template <typename F> void for_each_child(State state, F &&f) const {
+    for (auto [ch, label] : labels_) {
+      uint32_t index = state.base + label;
+      if (index < units_.size() && units_[index].label == label) {
+        auto unit = units_[index];
+        f(ch, State{unit.base, state.rank + unit.rank, unit.terminal != 0});
+      }
+    }
+  }
+
+  bool has_value_at(State state) const {
+    return state.terminal && values_[state.rank] != DEFAULT_VALUE;
+  }
+
+  const value_type &value_at(State state) const { return values_[state.rank]; }
+
+  //! number of keys, a key's rank is its index in key order
+  size_t size() const { return values_.size(); }
+
+  //! number of units, the used ones and the free ones
+  size_t n_units() const { return units_.size(); }
+
+private:
+  void build_labels() {
+    labels_.clear();
+    for (uint32_t ch = 0; ch < 256; ++ch) {
+      if (charmap_[ch] != 0)
+        labels_.push_back({static_cast<char>(ch), charmap_[ch]});
+    }
+  }
+
+  uint8_t charmap_[256];
+  // (char, label) of the chars of the keys, in char order
+  std::vector<std::pair<char, uint8_t>> labels_;
+  State root_{0, 0, false};
+
+  std::vector<DawgUnit, Allocator<DawgUnit>> units_;
+  std::vector<value_type, Allocator<value_type>> values_;
+};
+
+#ifdef ASSERT_CONCEPT
+static_assert(IsDeserializableTrie<DawgDoubleArrayTrie<>>);
+static_assert(IsKVTrie<DawgDoubleArrayTrie<>>);
+#endif
+
+} // namespace xtrie
+
+#endif // DAWG_DATRIE_H
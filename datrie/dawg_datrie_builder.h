@@ -0,0 +1,287 @@
+#ifndef DAWG_DATRIE_BUILDER_H
+#define DAWG_DATRIE_BUILDER_H
+
+#include "alphabet.h"
+#include "dawg_datrie.h"
+#include "serializers/format.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <dawg.h>
+#include <memory>
+#include <queue>
+#include <radix_sort.h>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#ifdef ASSERT_CONCEPT
+#include <trie_concepts.h>
+#endif
+
+namespace xtrie {
+
+//! @brief Builder for DawgDoubleArrayTrie
+//!
+//!     The keys go into a DAWG without their values, so that every suffix
+//!     shared by several keys is one node, and every node is placed once:
+//!     one block of units holding its transitions, which all the units
+//!     leading to the node point to. The values are kept apart in key
+//!     order, the walk finds the rank of a key by adding the ranks of its
+//!     transitions (see DawgUnit).
+//!
+//!     Blocks are placed first fit over the free units, like
+//!     DoubleArrayTrieBuilder, with the byte charmap ranking the chars by
+//!     frequency.
+template <typename T = int, T DefaultValue = -1>
+class DawgDoubleArrayTrieBuilder {
+public:
+  using value_type = T;
+  static constexpr value_type DEFAULT_VALUE = DefaultValue;
+
+  DawgDoubleArrayTrieBuilder() : build_(std::make_unique<BuildInfo>()) {}
+
+  //! @brief Add a key, after the ones added before in byte order
+  //!
+  //!     A key added again keeps its first value.
+  void add(std::string_view sv, T value) {
+    assert(units_.empty());
+
+    if (!values_.empty() && sv == build_->last_key)
+      return;
+    build_->last_key = sv;
+
+    build_->dawg.add(sv, 1);
+    values_.push_back(value);
+
+    for (char ch : sv) {
+      ++build_->char_freq[static_cast<uint8_t>(ch)];
+    }
+  }
+
+  //! @brief Add (key, value) pairs in any order, see DAWG::add_bulk
+  template <typename Range>
+  void add_bulk(const Range &pairs,
+                unsigned n_threads = std::thread::hardware_concurrency()) {
+    for_each_sorted_unique<T>(
+        pairs, [&](std::string_view key, T value) { add(key, value); },
+        n_threads);
+  }
+
+  void end_build() {
+    assert(units_.empty());
+
+    build_->dawg.end_build();
+    charmap_.build(build_->char_freq);
+    build_units();
+
+    build_.reset(nullptr);
+  }
+
+  //! @return number of bytes written
+  template <typename OStream> size_t save(OStream &os) const {
+    write_format_header(os, TrieFormat::DAWG);
+
+    uint32_t header[4] = {static_cast<uint32_t>(units_.size()),
+                          static_cast<uint32_t>(values_.size()), root_base_,
+                          root_terminal_};
+    os.write(reinterpret_cast<const char *>(header), sizeof(header));
+    charmap_.save(os);
+    os.write(reinterpret_cast<const char *>(units_.data()),
+             sizeof(DawgUnit) * units_.size());
+    os.write(reinterpret_cast<const char *>(values_.data()),
+             sizeof(T) * values_.size());
+
+    return 2 * sizeof(uint32_t) + sizeof(header) + charmap_.size() +
+           sizeof(DawgUnit) * units_.size() + sizeof(T) * values_.size();
+  }
+
+  //! number of units, the used ones and the free ones
+  size_t n_units() const { return units_.size(); }
+
+private:
+  using dawg_type = DAWG<int, -1>;
+  using node_type = typename dawg_type::Node;
+
+  struct BuildInfo {
+    dawg_type dawg;
+    std::string last_key;
+    std::unordered_map<uint8_t, size_t> char_freq;
+
+    // number of keys under every node, itself included
+    std::unordered_map<const node_type *, uint32_t> n_keys;
+    // base of the placed nodes with children
+    std::unordered_map<const node_type *, uint32_t> bases;
+
+    // next_free[i] leads to the first free unit from i, with path halving
+    std::vector<uint32_t> next_free;
+    std::vector<bool> used_bases;
+  };
+
+  struct Child {
+    uint8_t ch;
+    uint32_t label;
+    const node_type *node;
+  };
+
+  uint32_t count_keys(const node_type *node) {
+    auto it = build_->n_keys.find(node);
+    if (it != build_->n_keys.end())
+      return it->second;
+
+    uint32_t n = node->has_value() ? 1 : 0;
+    for (auto it = node->trans_begin(); it != node->trans_end(); ++it) {
+      n += count_keys(it.target());
+    }
+    build_->n_keys[node] = n;
+    return n;
+  }
+
+  void children_of(const node_type *node, std::vector<Child> &res) const {
+    res.clear();
+    for (auto it = node->trans_begin(); it != node->trans_end(); ++it) {
+      auto ch = static_cast<uint8_t>(it.key());
+      res.push_back({ch, charmap_[ch], it.target()});
+    }
+    // byte order, the order of the ranks
+    std::sort(res.begin(), res.end(),
+              [](const Child &a, const Child &b) { return a.ch < b.ch; });
+  }
+
+  //! the first free unit from i, units past the end are free
+  uint32_t first_free(uint32_t i) {
+    auto &next = build_->next_free;
+    while (i < next.size() && next[i] != i) {
+      if (next[i] < next.size())
+        next[i] = next[next[i]];
+      i = next[i];
+    }
+    return i;
+  }
+
+  void use(uint32_t i) {
+    auto &next = build_->next_free;
+    while (next.size() <= i + 1) {
+      next.push_back(static_cast<uint32_t>(next.size()));
+    }
+    next[i] = i + 1;
+  }
+
+  //! @brief Find a free block for the labels of children, and take it
+  uint32_t place(const std::vector<Child> &children) {
+    uint32_t min_label = children[0].label;
+    uint32_t max_label = children[0].label;
+    for (auto &c : children) {
+      min_label = std::min(min_label, c.label);
+      max_label = std::max(max_label, c.label);
+    }
+
+    auto &used_bases = build_->used_bases;
+    auto fits = [&](uint32_t base) {
+      if (base < used_bases.size() && used_bases[base])
+        return false;
+      for (auto &c : children) {
+        if (first_free(base + c.label) != base + c.label)
+          return false;
+      }
+      return true;
+    };
+
+    // bases start from 1, the leaves have base 0
+    uint32_t i = first_free(min_label + 1);
+    while (!fits(i - min_label)) {
+      i = first_free(i + 1);
+    }
+    uint32_t base = i - min_label;
+
+    if (base + max_label > DawgUnit::MAX_BASE)
+      throw std::length_error("too many units for the 23-bit bases");
+
+    if (base >= used_bases.size())
+      used_bases.resize(2 * (base + 1));
+    used_bases[base] = true;
+
+    for (auto &c : children) {
+      use(base + c.label);
+    }
+    if (units_.size() <= base + max_label)
+      units_.resize(base + max_label + 1);
+
+    return base;
+  }
+
+  void build_units() {
+    units_.clear();
+    use(0); // never a transition, bases start from 1
+
+    auto *root = build_->dawg.traverse("").state();
+    count_keys(root);
+    root_terminal_ = root->has_value();
+
+    std::vector<Child> children;
+    std::queue<const node_type *> q;
+
+    // the base of node, placing it the first time
+    auto base_of = [&](const node_type *node) -> uint32_t {
+      if (node->trans_size() == 0)
+        return 0;
+
+      auto it = build_->bases.find(node);
+      if (it != build_->bases.end())
+        return it->second;
+
+      children_of(node, children);
+      uint32_t base = place(children);
+      build_->bases[node] = base;
+      q.push(node);
+      return base;
+    };
+
+    root_base_ = base_of(root);
+
+    std::vector<Child> node_children;
+    while (!q.empty()) {
+      auto *node = q.front();
+      q.pop();
+
+      uint32_t base = build_->bases[node];
+      children_of(node, node_children);
+
+      uint32_t rank = node->has_value() ? 1 : 0;
+      for (auto &c : node_children) {
+        uint32_t child_base = base_of(c.node); // may grow units_
+
+        auto &unit = units_[base + c.label];
+        unit.label = c.label;
+        unit.terminal = c.node->has_value();
+        unit.base = child_base;
+        unit.rank = rank;
+
+        rank += build_->n_keys[c.node];
+      }
+    }
+
+    // nothing leads past the last transition
+    while (!units_.empty() && units_.back().label == 0)
+      units_.pop_back();
+  }
+
+  std::unique_ptr<BuildInfo> build_;
+
+  details::ByteCharmap<false> charmap_;
+  std::vector<DawgUnit> units_;
+  std::vector<T> values_; // in key order
+  uint32_t root_base_ = 0;
+  uint32_t root_terminal_ = 0;
+};
+
+#ifdef ASSERT_CONCEPT
+static_assert(IsStaticTrieBuilder<DawgDoubleArrayTrieBuilder<>>);
+#endif
+
+} // namespace xtrie
+
+#endif // DAWG_DATRIE_BUILDER_H
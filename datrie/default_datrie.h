@@ -1,9 +1,19 @@
 #ifndef DEFAULT_DATRIE_H
 #define DEFAULT_DATRIE_H
 
+#include "access_profile.h"
+#include "serializers/format.h"
+#include "value_layout.h"
 #include <cassert>
 #include <cstdint>
+#include <key_index.h>
+#include <key_range.h>
+#include <levenshtein.h>
 #include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #ifdef ASSERT_CONCEPT
@@ -12,10 +22,20 @@
 
 namespace xtrie {
 
-template <typename T = int, T DefaultValue = -1> class DefaultDoubleArrayTrie {
+//! @tparam T value type of 4 or 8 bytes, the format of the file must match
+//! @tparam Profile NoAccessProfile or AccessProfile
+//! @tparam Allocator of the arrays, std::allocator or HugePageAllocator
+//! @tparam Layout SplitLayout or InterleavedLayout
+template <typename T = int, T DefaultValue = -1,
+          typename Profile = NoAccessProfile,
+          template <typename> class Allocator = std::allocator,
+          typename Layout = SplitLayout>
+class DefaultDoubleArrayTrie {
 public:
   using value_type = T;
   static constexpr value_type DEFAULT_VALUE = DefaultValue;
+  static constexpr TrieFormat FORMAT =
+      value_format(TrieFormat::DEFAULT, sizeof(value_type));
 
   class TraverseResult {
     friend class DefaultDoubleArrayTrie;
@@ -39,10 +59,18 @@ private:
   static constexpr uint32_t MAX_CHAR_VAL = std::numeric_limits<uint8_t>::max();
 
 public:
+  //! @brief Read a trie saved with DefaultSerializer
+  //!
+  //!     Throws std::invalid_argument if the file isn't of the format of
+  //!     value_type, e.g. 8-byte values for an int trie. Files without
+  //!     header have 4-byte values.
   template <typename IStream> void load(IStream &is) {
 
     uint32_t size_sum;
-    is.read(reinterpret_cast<char *>(&size_sum), sizeof(uint32_t));
+    auto format = read_format_header(is, size_sum);
+    if (format != FORMAT && !(format == TrieFormat::UNKNOWN &&
+                              sizeof(value_type) == sizeof(uint32_t)))
+      throw std::invalid_argument("not a default trie of this value size");
 
     constexpr uint32_t charmap_size =
         static_cast<uint32_t>(sizeof(uint8_t)) * (MAX_CHAR_VAL + 1);
@@ -50,31 +78,36 @@ public:
     assert(size_sum > charmap_size);
 
     size_sum -= charmap_size;
-    bases_.resize(size_sum / sizeof(uint32_t));
-    values_.resize(size_sum / sizeof(uint32_t));
+    array_.resize(size_sum / sizeof(uint32_t));
 
     is.read(reinterpret_cast<char *>(charmap_), charmap_size);
+    build_labels();
 
-    for (size_t i = 0; i < bases_.size(); ++i) {
+    for (size_t i = 0; i < array_.size(); ++i) {
       uint32_t res;
       is.read(reinterpret_cast<char *>(&res), sizeof(uint32_t));
-      bases_[i].unit = res;
+      array_.unit(i).unit = res;
     }
 
-    for (size_t i = 0; i < values_.size(); ++i) {
-      is.read(reinterpret_cast<char *>(&values_[i]), sizeof(value_type));
+    for (size_t i = 0; i < array_.size(); ++i) {
+      is.read(reinterpret_cast<char *>(&array_.value(i)), sizeof(value_type));
     }
+
+    profile_.resize(array_.size());
   }
 
   TraverseResult traverse(std::string_view prefix, unsigned state_index) const {
     unsigned p = state_index;
+    profile_.visit(p, 0);
 
     uint32_t i = 0;
     for (; i < prefix.size(); ++i) {
       uint8_t mapped_ch = charmap_[static_cast<uint8_t>(prefix[i])];
-      unsigned new_base = bases_[p].base + mapped_ch;
-      if (new_base < bases_.size() && bases_[new_base].check == mapped_ch) {
+      unsigned new_base = array_.unit(p).base + mapped_ch;
+      if (mapped_ch != 0 && new_base < array_.size() &&
+          array_.unit(new_base).check == mapped_ch) {
         p = new_base;
+        profile_.visit(p, i + 1);
       } else {
         return {p, false, i};
       }
@@ -86,17 +119,100 @@ public:
     return traverse(prefix, 0);
   }
 
+  //! @brief Enumerate the transitions of a state
+  //!
+  //! @param f called as f(char, child state)
+  template <typename F> void for_each_child(unsigned state_index, F &&f) const {
+    for (auto [ch, mapped_ch] : labels_) {
+      unsigned child = array_.unit(state_index).base + mapped_ch;
+      if (child < array_.size() && array_.unit(child).check == mapped_ch)
+        f(ch, child);
+    }
+  }
+
+  //! number of units, the used ones and the free ones
+  size_t n_units() const { return array_.size(); }
+
+  //! @brief Find the keys within max_edits byte edits of query
+  //!
+  //!     The trie is walked with a LevenshteinAutomaton, only the labels
+  //!     used by the charmap are tried at each state.
+  //!
+  //! @param f called as f(key, state, distance) in key order
+  template <typename F>
+  void fuzzy_search(std::string_view query, uint32_t max_edits, F &&f) const {
+    levenshtein_walk(LevenshteinAutomaton(query, max_edits), *this, 0u, f);
+  }
+
+  //! @brief Index the parents of the states for restore_key()
+  //!
+  //!     Costs 4 bytes per unit and per key, see KeyIndex.
+  void build_key_index() { key_index_.build(*this, array_.size()); }
+
+  const KeyIndex &key_index() const { return key_index_; }
+
+  //! @brief Write the key of a state into buf, after build_key_index()
+  //!
+  //! @return length of the key, nothing is written if it is more than size
+  size_t restore_key(unsigned state_index, char *buf, size_t size) const {
+    return key_index_.restore(state_index, label_of(), buf, size);
+  }
+
+  //! state of the key of rank ordinal in key order
+  unsigned key_state(size_t ordinal) const { return key_index_.state(ordinal); }
+
+  //! rank in key order of the key of a state with a value
+  size_t key_ordinal(unsigned state_index) const {
+    return key_index_.ordinal(state_index, label_of());
+  }
+
+  //! @brief The keys in [lo, hi) in key order, see KeyRange
+  auto range(std::string_view lo, std::string_view hi) const {
+    return key_range(*this, lo, hi);
+  }
+
+  //! @brief Iterator to the first key not less than key
+  auto lower_bound(std::string_view key) const {
+    return key_lower_bound(*this, key);
+  }
+
+  const Profile &profile() const { return profile_; }
+
+  //! @brief Profiled visits as weights for DoubleArrayTrieBuilder::add_weight
+  AccessProfile::weights_type export_weights() const
+    requires Profile::enabled
+  {
+    return profile_.export_weights(
+        [this](unsigned state, auto &&f) { for_each_child(state, f); });
+  }
+
   bool has_value_at(unsigned state_index) const {
-    return values_[state_index] != DEFAULT_VALUE;
+    return array_.value(state_index) != DEFAULT_VALUE;
   }
 
   const value_type &value_at(unsigned state_index) const {
-    return values_[state_index];
+    return array_.value(state_index);
   }
 
-  value_type &value_at(unsigned state_index) { return values_[state_index]; }
+  value_type &value_at(unsigned state_index) {
+    return array_.value(state_index);
+  }
 
 private:
+  void build_labels() {
+    labels_.clear();
+    for (uint32_t ch = 0; ch <= MAX_CHAR_VAL; ++ch) {
+      if (charmap_[ch] != 0) {
+        labels_.push_back({static_cast<char>(ch), charmap_[ch]});
+        unmap_[charmap_[ch]] = static_cast<char>(ch);
+      }
+    }
+  }
+
+  auto label_of() const {
+    return [this](uint32_t state) { return unmap_[array_.unit(state).check]; };
+  }
+
   union CompactUnit {
     struct {
       unsigned check : 8;
@@ -109,8 +225,12 @@ private:
   static_assert(sizeof(CompactUnit) == sizeof(uint32_t));
 
   uint8_t charmap_[MAX_CHAR_VAL + 1];
-  std::vector<CompactUnit> bases_;
-  std::vector<value_type> values_;
+  // (char, mapped char) of the chars of the keys, in char order
+  std::vector<std::pair<char, uint8_t>> labels_;
+  char unmap_[MAX_CHAR_VAL + 1]; // mapped char to char
+  typename Layout::template Array<CompactUnit, value_type, Allocator> array_;
+  KeyIndex key_index_; // empty until build_key_index()
+  [[no_unique_address]] Profile profile_;
 };
 
 #ifdef ASSERT_CONCEPT
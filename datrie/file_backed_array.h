@@ -0,0 +1,112 @@
+#ifndef FILE_BACKED_ARRAY_H
+#define FILE_BACKED_ARRAY_H
+
+#include <algorithm>
+#include <external_sort.h>
+#include <filesystem>
+#include <fstream>
+#include <mio/mio.hpp>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+namespace xtrie {
+
+//! @brief Array in a mapped temporary file, for the builder arrays
+//!
+//!     Takes the part of std::vector the builder uses. The pages belong to
+//!     the page cache instead of the heap, so the OS writes them back and
+//!     drops them under memory pressure, and arrays larger than RAM can be
+//!     built.
+//!
+//!     The file is created under the temporary directory (TMPDIR on POSIX)
+//!     and removed with the array. It grows by doubling, every growth maps
+//!     the file again, so pointers into the array don't survive resize().
+template <typename T> class FileBackedArray {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+public:
+  FileBackedArray()
+      : path_(details::unique_temp_path(
+            std::filesystem::temp_directory_path(), "xtrie_array_")) {
+    std::ofstream create(path_, std::ios::binary | std::ios::trunc);
+    if (!create) {
+      throw std::filesystem::filesystem_error(
+          "cannot create array file", path_,
+          std::make_error_code(std::errc::io_error));
+    }
+  }
+
+  ~FileBackedArray() {
+    map_.unmap();
+    if (!path_.empty()) {
+      std::error_code error;
+      std::filesystem::remove(path_, error);
+    }
+  }
+
+  FileBackedArray(const FileBackedArray &) = delete;
+  FileBackedArray &operator=(const FileBackedArray &) = delete;
+
+  FileBackedArray(FileBackedArray &&b) noexcept
+      : path_(std::exchange(b.path_, {})), map_(std::move(b.map_)),
+        size_(std::exchange(b.size_, 0)),
+        capacity_(std::exchange(b.capacity_, 0)) {}
+
+  FileBackedArray &operator=(FileBackedArray &&b) noexcept {
+    std::swap(path_, b.path_);
+    std::swap(map_, b.map_);
+    std::swap(size_, b.size_);
+    std::swap(capacity_, b.capacity_);
+    return *this;
+  }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  T *data() { return reinterpret_cast<T *>(map_.data()); }
+  const T *data() const { return reinterpret_cast<const T *>(map_.data()); }
+
+  T &operator[](size_t i) { return data()[i]; }
+  const T &operator[](size_t i) const { return data()[i]; }
+
+  T *begin() { return data(); }
+  T *end() { return data() + size_; }
+  const T *begin() const { return data(); }
+  const T *end() const { return data() + size_; }
+
+  //! new elements are set to value, the file never shrinks
+  void resize(size_t n, const T &value = T()) {
+    if (n > capacity_)
+      reserve(std::max(n, capacity_ * 2));
+
+    std::fill(data() + std::min(size_, n), data() + n, value);
+    size_ = n;
+  }
+
+  void reserve(size_t n) {
+    if (n <= capacity_)
+      return;
+
+    map_.unmap();
+    std::filesystem::resize_file(path_, n * sizeof(T));
+
+    std::error_code error;
+    map_.map(path_.string(), error);
+    if (error)
+      throw std::filesystem::filesystem_error("cannot map array file", path_,
+                                              error);
+
+    capacity_ = n;
+  }
+
+private:
+  std::filesystem::path path_;
+  mio::mmap_sink map_;
+  size_t size_ = 0;
+  size_t capacity_ = 0;
+};
+
+} // namespace xtrie
+
+#endif // FILE_BACKED_ARRAY_H
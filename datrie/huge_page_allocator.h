@@ -0,0 +1,95 @@
+#ifndef HUGE_PAGE_ALLOCATOR_H
+#define HUGE_PAGE_ALLOCATOR_H
+
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <string>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace xtrie {
+
+//! @brief Allocator putting large arrays on transparent huge pages
+//!
+//!     Lookups in a large double array land on random pages, with 4 KB pages
+//!     every one of them is a dTLB miss. An allocation of at least half a
+//!     huge page is rounded up to whole 2 MB pages, aligned to 2 MB and
+//!     advised with MADV_HUGEPAGE before anything touches it, so the kernel
+//!     can fault it in as huge pages.
+//!
+//!     If the kernel has THP disabled, or no huge page is free, the memory
+//!     simply stays on 4 KB pages. Smaller allocations and other OSes go
+//!     through std::allocator.
+template <typename T> class HugePageAllocator {
+public:
+  using value_type = T;
+
+  static constexpr size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+
+  HugePageAllocator() = default;
+
+  template <typename U>
+  HugePageAllocator(const HugePageAllocator<U> &) noexcept {}
+
+  T *allocate(size_t n) {
+    size_t bytes = n * sizeof(T);
+    if (!on_huge_pages(bytes))
+      return std::allocator<T>().allocate(n);
+
+    void *p = ::operator new(round_up(bytes), std::align_val_t(HUGE_PAGE_SIZE));
+#ifdef MADV_HUGEPAGE
+    madvise(p, round_up(bytes), MADV_HUGEPAGE); // a hint, may fail
+#endif
+    return static_cast<T *>(p);
+  }
+
+  void deallocate(T *p, size_t n) noexcept {
+    size_t bytes = n * sizeof(T);
+    if (!on_huge_pages(bytes)) {
+      std::allocator<T>().deallocate(p, n);
+      return;
+    }
+
+    ::operator delete(p, round_up(bytes), std::align_val_t(HUGE_PAGE_SIZE));
+  }
+
+  //! @brief Whether the kernel gives huge pages to madvised memory
+  static bool available() {
+#ifdef MADV_HUGEPAGE
+    std::ifstream ifs("/sys/kernel/mm/transparent_hugepage/enabled");
+    std::string mode;
+    std::getline(ifs, mode);
+    return mode.find("[always]") != std::string::npos ||
+           mode.find("[madvise]") != std::string::npos;
+#else
+    return false;
+#endif
+  }
+
+  template <typename U>
+  bool operator==(const HugePageAllocator<U> &) const noexcept {
+    return true;
+  }
+
+private:
+  static bool on_huge_pages(size_t bytes) {
+#ifdef MADV_HUGEPAGE
+    return bytes >= HUGE_PAGE_SIZE / 2;
+#else
+    (void)bytes;
+    return false;
+#endif
+  }
+
+  static size_t round_up(size_t bytes) {
+    return (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  }
+};
+
+} // namespace xtrie
+
+#endif // HUGE_PAGE_ALLOCATOR_H
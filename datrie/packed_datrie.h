@@ -0,0 +1,202 @@
+#ifndef PACKED_DATRIE_H
+#define PACKED_DATRIE_H
+
+#include "serializers/format.h"
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#ifdef ASSERT_CONCEPT
+#include <trie_concepts.h>
+#endif
+
+namespace xtrie {
+
+//! @brief Read only double array trie of bit-packed units, see
+//! PackedSerializer
+//!
+//!     A unit is found from the directory entry of its block, then decoded
+//!     with one unaligned 8-byte load, a shift and a mask. A transition
+//!     decodes two units, it costs more than in DefaultDoubleArrayTrie, for
+//!     units of about half the size.
+//!
+//! @tparam T value type of 4 or 8 bytes, the format of the file must match
+template <typename T = int, T DefaultValue = -1,
+          template <typename> class Allocator = std::allocator>
+class PackedDoubleArrayTrie {
+public:
+  using value_type = T;
+  static constexpr value_type DEFAULT_VALUE = DefaultValue;
+  static constexpr TrieFormat FORMAT =
+      value_format(TrieFormat::PACKED, sizeof(value_type));
+
+  class TraverseResult {
+    friend class PackedDoubleArrayTrie;
+
+  public:
+    unsigned state() const { return state_index_; }
+    bool matched() const { return matched_; }
+    uint32_t matched_length() const { return matched_length_; }
+
+  private:
+    unsigned state_index_;
+    bool matched_;
+    uint32_t matched_length_;
+
+    TraverseResult(unsigned state_index, bool matched, uint32_t matched_length)
+        : state_index_(state_index), matched_(matched),
+          matched_length_(matched_length) {}
+  };
+
+private:
+  static constexpr uint32_t MAX_CHAR_VAL = std::numeric_limits<uint8_t>::max();
+
+public:
+  //! @brief Read a trie saved with PackedSerializer
+  //!
+  //!     Throws std::invalid_argument if the file isn't of the format of
+  //!     value_type, e.g. 8-byte values for an int trie.
+  template <typename IStream> void load(IStream &is) {
+    uint32_t size_sum;
+    if (read_format_header(is, size_sum) != FORMAT)
+      throw std::invalid_argument("not a packed trie of this value size");
+
+    is.read(reinterpret_cast<char *>(charmap_), sizeof(charmap_));
+    build_labels();
+
+    uint32_t header[6];
+    is.read(reinterpret_cast<char *>(header), sizeof(header));
+    if (header[5] != sizeof(value_type))
+      throw std::invalid_argument("not a packed trie of this value size");
+    n_units_ = header[0];
+    check_width_ = header[1];
+    check_mask_ = (uint64_t(1) << check_width_) - 1;
+    block_shift_ = header[2];
+
+    directory_.resize(header[3]);
+    is.read(reinterpret_cast<char *>(directory_.data()),
+            sizeof(BlockEntry) * directory_.size());
+
+    units_.resize(header[4]);
+    is.read(units_.data(), static_cast<std::streamsize>(units_.size()));
+
+    values_.resize(n_units_);
+    is.read(reinterpret_cast<char *>(values_.data()),
+            sizeof(value_type) * values_.size());
+  }
+
+  TraverseResult traverse(std::string_view prefix, unsigned state_index) const {
+    unsigned p = state_index;
+
+    uint32_t i = 0;
+    for (; i < prefix.size(); ++i) {
+      uint8_t mapped_ch = charmap_[static_cast<uint8_t>(prefix[i])];
+      unsigned child = base_of(unit(p)) + mapped_ch;
+      if (mapped_ch != 0 && child < n_units_ &&
+          check_of(unit(child)) == mapped_ch) {
+        p = child;
+      } else {
+        return {p, false, i};
+      }
+    }
+    return {p, true, i};
+  }
+
+  TraverseResult traverse(std::string_view prefix) const {
+    return traverse(prefix, 0);
+  }
+
+  //! @brief Enumerate the transitions of a state
+  //!
+  //! @param f called as f(char, child state)
+  template <typename F> void for_each_child(unsigned state_index, F &&f) const {
+    unsigned base = base_of(unit(state_index));
+    for (auto [ch, mapped_ch] : labels_) {
+      unsigned child = base + mapped_ch;
+      if (child < n_units_ && check_of(unit(child)) == mapped_ch)
+        f(ch, child);
+    }
+  }
+
+  bool has_value_at(unsigned state_index) const {
+    return values_[state_index] != DEFAULT_VALUE;
+  }
+
+  const value_type &value_at(unsigned state_index) const {
+    return values_[state_index];
+  }
+
+  //! number of units, the used ones and the free ones
+  size_t n_units() const { return n_units_; }
+
+  //! bytes of the directory and the packed units, the values excluded
+  size_t units_size() const {
+    return sizeof(BlockEntry) * directory_.size() + units_.size();
+  }
+
+private:
+  struct BlockEntry {
+    uint32_t ref_width; // reference base << 8 | width of the units
+    uint32_t offset;    // of the units of the block
+  };
+
+  struct Unit {
+    uint32_t ref;
+    uint64_t field; // (base - ref + 1) << check width | check
+  };
+
+  Unit unit(unsigned i) const {
+    auto entry = directory_[i >> block_shift_];
+    uint32_t width = entry.ref_width & 0xff;
+    size_t bit = static_cast<size_t>(i & ((1u << block_shift_) - 1)) * width;
+
+    uint64_t window;
+    memcpy(&window, units_.data() + entry.offset + bit / 8, sizeof(window));
+    uint64_t mask = (uint64_t(1) << width) - 1;
+    return {entry.ref_width >> 8, (window >> (bit % 8)) & mask};
+  }
+
+  uint32_t check_of(Unit u) const {
+    return static_cast<uint32_t>(u.field & check_mask_);
+  }
+
+  unsigned base_of(Unit u) const {
+    auto delta = static_cast<uint32_t>(u.field >> check_width_);
+    return delta == 0 ? 0 : u.ref + delta - 1;
+  }
+
+  void build_labels() {
+    labels_.clear();
+    for (uint32_t ch = 0; ch <= MAX_CHAR_VAL; ++ch) {
+      if (charmap_[ch] != 0)
+        labels_.push_back({static_cast<char>(ch), charmap_[ch]});
+    }
+  }
+
+  uint8_t charmap_[MAX_CHAR_VAL + 1];
+  // (char, mapped char) of the chars of the keys, in char order
+  std::vector<std::pair<char, uint8_t>> labels_;
+
+  uint32_t n_units_ = 0;
+  uint32_t check_width_ = 0;
+  uint64_t check_mask_ = 0;
+  uint32_t block_shift_ = 0;
+  std::vector<BlockEntry, Allocator<BlockEntry>> directory_;
+  std::vector<char, Allocator<char>> units_;
+  std::vector<value_type, Allocator<value_type>> values_;
+};
+
+#ifdef ASSERT_CONCEPT
+static_assert(IsDeserializableTrie<PackedDoubleArrayTrie<>>);
+static_assert(IsKVTrie<PackedDoubleArrayTrie<>>);
+#endif
+
+} // namespace xtrie
+
+#endif // PACKED_DATRIE_H
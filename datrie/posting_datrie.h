@@ -0,0 +1,78 @@
+#ifndef POSTING_DATRIE_H
+#define POSTING_DATRIE_H
+
+#include "blob_datrie.h"
+#include "posting_list.h"
+#include <memory>
+#include <string_view>
+
+#ifdef ASSERT_CONCEPT
+#include <trie_concepts.h>
+#endif
+
+namespace xtrie {
+
+//! @brief Term dictionary of an inverted index: a double array trie whose
+//! values are posting lists, see PostingDoubleArrayTrieBuilder
+//!
+//!     The lists are blobs of a BlobDoubleArrayTrie, so a lookup ends on a
+//!     PostingList viewing the pool of the loaded or mapped file, which a
+//!     Cursor decodes block by block.
+template <template <typename> class Allocator = std::allocator>
+class PostingDoubleArrayTrie {
+  using trie_type = BlobDoubleArrayTrie<Allocator>;
+
+public:
+  using value_type = PostingList;
+  static constexpr value_type DEFAULT_VALUE{};
+
+  using TraverseResult = typename trie_type::TraverseResult;
+
+  template <typename IStream> void load(IStream &is) { trie_.load(is); }
+
+  //! @brief See BlobDoubleArrayTrie::map
+  bool map(const char *path) { return trie_.map(path); }
+
+  TraverseResult traverse(std::string_view prefix, unsigned state) const {
+    return trie_.traverse(prefix, state);
+  }
+
+  TraverseResult traverse(std::string_view prefix) const {
+    return trie_.traverse(prefix);
+  }
+
+  bool has_value_at(unsigned state) const { return trie_.has_value_at(state); }
+
+  //! the empty list for a state without a key
+  value_type value_at(unsigned state) const {
+    return PostingList(trie_.value_at(state));
+  }
+
+  //! @brief The list of a term, empty if it is not a key
+  value_type postings(std::string_view term) const {
+    auto res = trie_.traverse(term);
+    return res.matched() ? value_at(res.state()) : DEFAULT_VALUE;
+  }
+
+  template <typename F> void for_each_child(unsigned state, F &&f) const {
+    trie_.for_each_child(state, f);
+  }
+
+  //! number of units, the used ones and the free ones
+  size_t n_units() const { return trie_.n_units(); }
+
+  //! the encoded lists, each distinct one once
+  const BlobPool &pool() const { return trie_.pool(); }
+
+private:
+  trie_type trie_;
+};
+
+#ifdef ASSERT_CONCEPT
+static_assert(IsDeserializableTrie<PostingDoubleArrayTrie<>>);
+static_assert(IsKVTrie<PostingDoubleArrayTrie<>>);
+#endif
+
+} // namespace xtrie
+
+#endif // POSTING_DATRIE_H
@@ -0,0 +1,70 @@
+#ifndef POSTING_DATRIE_BUILDER_H
+#define POSTING_DATRIE_BUILDER_H
+
+#include "blob_datrie_builder.h"
+#include "posting_list.h"
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef ASSERT_CONCEPT
+#include <trie_concepts.h>
+#endif
+
+namespace xtrie {
+
+//! @brief Builder for PostingDoubleArrayTrie
+//!
+//!     Every list of document IDs is encoded by encode_posting_list and
+//!     added as the blob of its term, terms with the same list share it.
+//!     A term with an empty list is not added.
+class PostingDoubleArrayTrieBuilder {
+public:
+  using value_type = std::span<const uint32_t>;
+  static constexpr value_type DEFAULT_VALUE{};
+
+  //! @param doc_ids sorted and distinct
+  void add(std::string_view term, std::span<const uint32_t> doc_ids) {
+    if (!doc_ids.empty())
+      builder_.add(term, encode_posting_list(doc_ids));
+  }
+
+  //! @brief Add (term, doc IDs) pairs in any order, see DAWG::add_bulk
+  template <typename Range>
+  void add_bulk(const Range &pairs,
+                unsigned n_threads = std::thread::hardware_concurrency()) {
+    std::vector<std::pair<std::string_view, std::string>> encoded;
+    for (auto &[term, doc_ids] : pairs) {
+      if (!std::empty(doc_ids))
+        encoded.push_back({term, encode_posting_list(doc_ids)});
+    }
+    builder_.add_bulk(encoded, n_threads);
+  }
+
+  void end_build() { builder_.end_build(); }
+
+  //! @brief See BlobDoubleArrayTrieBuilder::save
+  template <typename OStream> size_t save(OStream &os) const {
+    return builder_.save(os);
+  }
+
+  const BuildReport &build_report() const { return builder_.build_report(); }
+
+  //! number of distinct non empty lists
+  size_t n_lists() const { return builder_.n_blobs(); }
+
+private:
+  BlobDoubleArrayTrieBuilder builder_;
+};
+
+#ifdef ASSERT_CONCEPT
+static_assert(IsStaticTrieBuilder<PostingDoubleArrayTrieBuilder>);
+#endif
+
+} // namespace xtrie
+
+#endif // POSTING_DATRIE_BUILDER_H
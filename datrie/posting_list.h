@@ -0,0 +1,326 @@
+#ifndef DATRIE_POSTING_LIST_H
+#define DATRIE_POSTING_LIST_H
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace xtrie {
+
+namespace details {
+
+//! @brief Fixed width deltas of frame of reference blocks
+//!
+//!     One function per width, so that the masks are constants and the
+//!     unpack loop has no branch and no dependency between iterations: one
+//!     unaligned 8-byte load, a shift and a mask per delta. The prefix sum
+//!     is a second loop.
+struct PostingBlockCodec {
+  static constexpr uint32_t BLOCK_SIZE = 128;
+
+  using unpack_type = void (*)(const uint8_t *, const uint8_t *, uint32_t,
+                               uint32_t *);
+
+  //! bytes of n deltas of width bits
+  static size_t packed_size(uint32_t n, uint32_t width) {
+    return (static_cast<size_t>(n) * width + 7) / 8;
+  }
+
+  static void pack(const uint32_t *deltas, uint32_t n, uint32_t width,
+                   std::string &out) {
+    size_t begin = out.size();
+    out.resize(begin + packed_size(n, width));
+    auto *p = reinterpret_cast<uint8_t *>(out.data() + begin);
+
+    size_t bit = 0;
+    for (uint32_t i = 0; i < n; ++i, bit += width) {
+      uint64_t v = static_cast<uint64_t>(deltas[i]) << (bit % 8);
+      for (size_t byte = bit / 8; v != 0; ++byte, v >>= 8) {
+        p[byte] |= static_cast<uint8_t>(v);
+      }
+    }
+  }
+
+private:
+  template <size_t... Widths>
+  static constexpr std::array<unpack_type, sizeof...(Widths)>
+  make_table(std::index_sequence<Widths...>) {
+    return {&unpack_width<Widths>...};
+  }
+
+  template <uint32_t Width>
+  static void unpack_width(const uint8_t *p, const uint8_t *end, uint32_t n,
+                           uint32_t *out) {
+    if constexpr (Width == 0) {
+      std::fill(out, out + n, 0);
+    } else {
+      constexpr uint64_t MASK = (uint64_t(1) << Width) - 1;
+
+      // 8 bytes are read from the byte of every delta, the deltas whose
+      // window runs past end are read byte by byte
+      uint32_t n_fast = 0;
+      if (static_cast<size_t>(end - p) >= 8)
+        n_fast = std::min<uint32_t>(
+            n, static_cast<uint32_t>((end - p - 8) * 8 / Width + 1));
+
+      for (uint32_t i = 0; i < n_fast; ++i) {
+        size_t bit = static_cast<size_t>(i) * Width;
+        uint64_t window;
+        memcpy(&window, p + bit / 8, sizeof(window));
+        out[i] = static_cast<uint32_t>((window >> (bit % 8)) & MASK);
+      }
+      for (uint32_t i = n_fast; i < n; ++i) {
+        size_t bit = static_cast<size_t>(i) * Width;
+        uint64_t window = 0;
+        size_t first = bit / 8;
+        size_t last = std::min<size_t>(first + 8, end - p);
+        for (size_t byte = first; byte < last; ++byte) {
+          window |= static_cast<uint64_t>(p[byte]) << (8 * (byte - first));
+        }
+        out[i] = static_cast<uint32_t>((window >> (bit % 8)) & MASK);
+      }
+    }
+  }
+
+public:
+  //! @brief Unpack n deltas of width bits from [p, end) into out
+  static void unpack(uint32_t width, const uint8_t *p, const uint8_t *end,
+                     uint32_t n, uint32_t *out) {
+    static constexpr auto table = make_table(std::make_index_sequence<33>());
+    assert(width <= 32);
+    table[width](p, end, n, out);
+  }
+};
+
+} // namespace details
+
+//! @brief Append the encoding of a sorted list of distinct document IDs
+//!
+//!     The list is the number of IDs as a LEB128 varint, a skip table when
+//!     there is more than one block, and the blocks. A block is 128 IDs (the
+//!     last one fewer) stored as deltas from the previous ID, the first
+//!     delta from the last ID of the previous block, or from 0: one byte
+//!     for the width of the largest delta, then the deltas bit-packed at
+//!     that width (frame of reference). The skip table has the last ID and
+//!     the byte offset of every block, as two unaligned uint32_t, for
+//!     PostingList::Cursor::advance() to jump to the block of an ID.
+inline void encode_posting_list(std::span<const uint32_t> doc_ids,
+                                std::string &out) {
+  using Codec = details::PostingBlockCodec;
+  assert(std::is_sorted(doc_ids.begin(), doc_ids.end()) &&
+         std::adjacent_find(doc_ids.begin(), doc_ids.end()) == doc_ids.end());
+
+  size_t n = doc_ids.size();
+  for (size_t v = n;; v >>= 7) {
+    out.push_back(static_cast<char>(v >= 0x80 ? (v & 0x7f) | 0x80 : v));
+    if (v < 0x80)
+      break;
+  }
+
+  size_t n_blocks = (n + Codec::BLOCK_SIZE - 1) / Codec::BLOCK_SIZE;
+  size_t skip_table = out.size();
+  if (n_blocks > 1)
+    out.resize(out.size() + n_blocks * 2 * sizeof(uint32_t));
+  size_t blocks = out.size();
+
+  uint32_t deltas[Codec::BLOCK_SIZE];
+  uint32_t prev = 0;
+  for (size_t b = 0; b < n_blocks; ++b) {
+    size_t first = b * Codec::BLOCK_SIZE;
+    auto size =
+        static_cast<uint32_t>(std::min<size_t>(Codec::BLOCK_SIZE, n - first));
+
+    uint32_t max_delta = 0;
+    for (uint32_t i = 0; i < size; ++i) {
+      deltas[i] = doc_ids[first + i] - prev;
+      prev = doc_ids[first + i];
+      max_delta = std::max(max_delta, deltas[i]);
+    }
+
+    if (n_blocks > 1) {
+      uint32_t entry[2] = {prev, static_cast<uint32_t>(out.size() - blocks)};
+      memcpy(out.data() + skip_table + b * sizeof(entry), entry, sizeof(entry));
+    }
+
+    auto width = static_cast<uint32_t>(std::bit_width(max_delta));
+    out.push_back(static_cast<char>(width));
+    Codec::pack(deltas, size, width, out);
+  }
+}
+
+inline std::string encode_posting_list(std::span<const uint32_t> doc_ids) {
+  std::string res;
+  encode_posting_list(doc_ids, res);
+  return res;
+}
+
+//! @brief View of a list written by encode_posting_list
+//!
+//!     Nothing is decoded until a Cursor walks the list, one block at a time
+//!     into a buffer of its own, so iterating allocates nothing.
+class PostingList {
+  using Codec = details::PostingBlockCodec;
+
+public:
+  static constexpr uint32_t BLOCK_SIZE = Codec::BLOCK_SIZE;
+
+  constexpr PostingList() = default;
+
+  explicit PostingList(std::string_view encoded)
+      : end_(reinterpret_cast<const uint8_t *>(encoded.data() +
+                                               encoded.size())) {
+    if (encoded.empty())
+      return;
+
+    const auto *p = reinterpret_cast<const uint8_t *>(encoded.data());
+    for (unsigned shift = 0;; shift += 7) {
+      size_ |= static_cast<uint32_t>(*p & 0x7f) << shift;
+      if ((*p++ & 0x80) == 0)
+        break;
+    }
+
+    n_blocks_ = (size_ + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    skip_table_ = p;
+    blocks_ = n_blocks_ > 1 ? p + n_blocks_ * 2 * sizeof(uint32_t) : p;
+  }
+
+  //! number of document IDs
+  uint32_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  class Cursor;
+  class iterator;
+
+  Cursor cursor() const;
+
+  iterator begin() const;
+  std::default_sentinel_t end() const { return {}; }
+
+private:
+  uint32_t last_doc(uint32_t block) const {
+    uint32_t res;
+    memcpy(&res, skip_table_ + block * 2 * sizeof(uint32_t), sizeof(res));
+    return res;
+  }
+
+  uint32_t block_offset(uint32_t block) const {
+    uint32_t res;
+    memcpy(&res, skip_table_ + (block * 2 + 1) * sizeof(uint32_t),
+           sizeof(res));
+    return res;
+  }
+
+  uint32_t size_ = 0;
+  uint32_t n_blocks_ = 0;
+  const uint8_t *skip_table_ = nullptr;
+  const uint8_t *blocks_ = nullptr;
+  const uint8_t *end_ = nullptr;
+};
+
+//! @brief Position in a list, on one ID until done()
+class PostingList::Cursor {
+public:
+  explicit Cursor(const PostingList &list) : list_(list) {
+    if (!list.empty())
+      decode_block(0, list.blocks_, 0);
+  }
+
+  bool done() const { return i_ == size_; }
+  uint32_t doc() const { return docs_[i_]; }
+
+  void next() {
+    assert(!done());
+    if (++i_ == size_ && block_ + 1 < list_.n_blocks_)
+      decode_block(block_ + 1, next_block_, docs_[i_ - 1]);
+  }
+
+  //! @brief Move to the first ID not less than target, never backwards
+  //!
+  //!     The blocks ending before target are skipped through the skip
+  //!     table without being decoded.
+  void advance(uint32_t target) {
+    if (done() || doc() >= target)
+      return;
+
+    if (docs_[size_ - 1] < target) {
+      uint32_t b = block_ + 1;
+      while (b < list_.n_blocks_ && list_.last_doc(b) < target) {
+        ++b;
+      }
+      if (b == list_.n_blocks_) {
+        i_ = size_;
+        return;
+      }
+      decode_block(b, list_.blocks_ + list_.block_offset(b),
+                   list_.last_doc(b - 1));
+    }
+
+    i_ = static_cast<uint32_t>(
+        std::lower_bound(docs_ + i_, docs_ + size_, target) - docs_);
+  }
+
+private:
+  void decode_block(uint32_t block, const uint8_t *p, uint32_t prev) {
+    block_ = block;
+    size_ = std::min(BLOCK_SIZE, list_.size_ - block * BLOCK_SIZE);
+    i_ = 0;
+
+    uint32_t width = *p++;
+    Codec::unpack(width, p, list_.end_, size_, docs_);
+    for (uint32_t i = 0; i < size_; ++i) {
+      prev += docs_[i];
+      docs_[i] = prev;
+    }
+    next_block_ = p + Codec::packed_size(size_, width);
+  }
+
+  PostingList list_; // a copy, the cursor may outlive the view
+  uint32_t block_ = 0;
+  uint32_t size_ = 0; // of the block
+  uint32_t i_ = 0;
+  const uint8_t *next_block_ = nullptr;
+  uint32_t docs_[BLOCK_SIZE];
+};
+
+class PostingList::iterator {
+public:
+  using value_type = uint32_t;
+  using difference_type = std::ptrdiff_t;
+  using iterator_category = std::input_iterator_tag;
+
+  explicit iterator(const PostingList &list) : cursor_(list) {}
+
+  uint32_t operator*() const { return cursor_.doc(); }
+
+  iterator &operator++() {
+    cursor_.next();
+    return *this;
+  }
+
+  void operator++(int) { cursor_.next(); }
+
+  bool operator==(std::default_sentinel_t) const { return cursor_.done(); }
+
+private:
+  Cursor cursor_;
+};
+
+inline PostingList::Cursor PostingList::cursor() const {
+  return Cursor(*this);
+}
+
+inline PostingList::iterator PostingList::begin() const {
+  return iterator(*this);
+}
+
+} // namespace xtrie
+
+#endif // DATRIE_POSTING_LIST_H
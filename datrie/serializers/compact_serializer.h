@@ -1,6 +1,7 @@
 #ifndef DATRIE_COMPACT_SERIALIZER
 #define DATRIE_COMPACT_SERIALIZER
 
+#include "format.h"
 #include <cstdint>
 #include <vector>
 
@@ -18,17 +19,16 @@ namespace xtrie {
 //!     base is value, 0 means not a terminal node (no value).
 //!
 struct CompactSerializer {
-  template <typename T>
-  size_t get_size(const std::vector<int64_t> &base,
-                  const std::vector<int64_t> &, const std::vector<T> &,
-                  T) const {
+  static constexpr TrieFormat FORMAT = TrieFormat::COMPACT;
+
+  template <typename Units, typename Values, typename T>
+  size_t get_size(const Units &base, const Units &, const Values &, T) const {
     return sizeof(uint32_t) * base.size();
   }
 
-  template <typename OStream, typename T>
-  void operator()(OStream &os, const std::vector<int64_t> &base,
-                  const std::vector<int64_t> &check,
-                  const std::vector<T> &value, T default_value) const {
+  template <typename OStream, typename Units, typename Values, typename T>
+  void operator()(OStream &os, const Units &base, const Units &check,
+                  const Values &value, T default_value) const {
     static_assert(sizeof(T) <= sizeof(uint32_t));
 
     union {
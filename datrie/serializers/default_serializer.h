@@ -1,6 +1,7 @@
 #ifndef DATRIE_DEFAULT_SERIALIZER
 #define DATRIE_DEFAULT_SERIALIZER
 
+#include "format.h"
 #include <cstdint>
 #include <vector>
 
@@ -13,21 +14,22 @@ namespace xtrie {
 //!
 //!     24 bit for base, 8 bit for check.
 //!
-//!     values will be saved in another array at the end.
+//!     values will be saved in another array at the end, 4 or 8 bytes
+//!     each, the files of 8-byte values are TrieFormat::DEFAULT64.
 //!
 struct DefaultSerializer {
-  template <typename T>
-  size_t get_size(const std::vector<int64_t> &base,
-                  const std::vector<int64_t> &, const std::vector<T> &,
-                  T) const {
+  static constexpr TrieFormat FORMAT = TrieFormat::DEFAULT;
+
+  template <typename Units, typename Values, typename T>
+  size_t get_size(const Units &base, const Units &, const Values &, T) const {
     return sizeof(uint32_t) * base.size();
   }
 
-  template <typename OStream, typename T>
-  void operator()(OStream &os, const std::vector<int64_t> &base,
-                  const std::vector<int64_t> &check,
-                  const std::vector<T> &value, T default_value) const {
-    static_assert(sizeof(T) <= sizeof(uint32_t));
+  template <typename OStream, typename Units, typename Values, typename T>
+  void operator()(OStream &os, const Units &base, const Units &check,
+                  const Values &value, T default_value) const {
+    static_assert(sizeof(T) == sizeof(uint32_t) ||
+                  sizeof(T) == sizeof(uint64_t));
 
     union {
       CompactUnit unit;
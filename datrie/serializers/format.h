@@ -0,0 +1,75 @@
+#ifndef DATRIE_FORMAT_H
+#define DATRIE_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace xtrie {
+
+//! @brief Layout of the units written by a serializer
+//!
+//!     Saved in the file header, so that a file can be loaded without
+//!     knowing which serializer wrote it (see AnyTrie).
+enum class TrieFormat : uint32_t {
+  UNKNOWN = 0, // file written before the header existed
+  NO_VALUE = 1,
+  DEFAULT = 2,
+  COMPACT = 3,
+  WIDE = 4,
+  DAWG = 5, // DawgDoubleArrayTrieBuilder
+  BLOB = 6, // BlobDoubleArrayTrieBuilder
+  PACKED = 7, // PackedSerializer
+  DEFAULT64 = 8, // DefaultSerializer, 8-byte values
+  PACKED64 = 9,  // PackedSerializer, 8-byte values
+};
+
+//! @brief Format of a file whose values are value_size bytes each
+//!
+//!     The files of 8-byte values have a format of their own, a runtime
+//!     reading 4-byte values tells them apart instead of misreading them.
+constexpr TrieFormat value_format(TrieFormat format, size_t value_size) {
+  if (value_size != sizeof(uint64_t))
+    return format;
+
+  switch (format) {
+  case TrieFormat::DEFAULT:
+    return TrieFormat::DEFAULT64;
+  case TrieFormat::PACKED:
+    return TrieFormat::PACKED64;
+  default:
+    return format;
+  }
+}
+
+//! "XTRI", never a plausible size_sum of a file without header
+static constexpr uint32_t FORMAT_MAGIC = 0x49525458;
+
+//! @brief Header of a saved trie: magic, then the format
+template <typename OStream>
+void write_format_header(OStream &os, TrieFormat format) {
+  uint32_t header[2] = {FORMAT_MAGIC, static_cast<uint32_t>(format)};
+  os.write(reinterpret_cast<const char *>(header), sizeof(header));
+}
+
+//! @brief Read the header and the size_sum word which follows it
+//!
+//!     Files written without a header start with size_sum, they are read as
+//!     TrieFormat::UNKNOWN.
+template <typename IStream>
+TrieFormat read_format_header(IStream &is, uint32_t &size_sum) {
+  uint32_t word;
+  is.read(reinterpret_cast<char *>(&word), sizeof(uint32_t));
+  if (word != FORMAT_MAGIC) {
+    size_sum = word;
+    return TrieFormat::UNKNOWN;
+  }
+
+  uint32_t format;
+  is.read(reinterpret_cast<char *>(&format), sizeof(uint32_t));
+  is.read(reinterpret_cast<char *>(&size_sum), sizeof(uint32_t));
+  return static_cast<TrieFormat>(format);
+}
+
+} // namespace xtrie
+
+#endif // DATRIE_FORMAT_H
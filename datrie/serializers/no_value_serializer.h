@@ -1,6 +1,7 @@
 #ifndef DATRIE_NO_VALUE_SERIALIZER
 #define DATRIE_NO_VALUE_SERIALIZER
 
+#include "format.h"
 #include <cstdint>
 #include <vector>
 
@@ -15,17 +16,16 @@ namespace xtrie {
 //!     23 bit for base, 8 bit for check, 1 bit for terminal flag.
 //!
 struct NoValueSerializer {
-  template <typename T>
-  size_t get_size(const std::vector<int64_t> &base,
-                  const std::vector<int64_t> &, const std::vector<T> &,
-                  T) const {
+  static constexpr TrieFormat FORMAT = TrieFormat::NO_VALUE;
+
+  template <typename Units, typename Values, typename T>
+  size_t get_size(const Units &base, const Units &, const Values &, T) const {
     return sizeof(uint32_t) * base.size();
   }
 
-  template <typename OStream, typename T>
-  void operator()(OStream &os, const std::vector<int64_t> &base,
-                  const std::vector<int64_t> &check,
-                  const std::vector<T> &value, T default_value) const {
+  template <typename OStream, typename Units, typename Values, typename T>
+  void operator()(OStream &os, const Units &base, const Units &check,
+                  const Values &value, T default_value) const {
 
     union {
       CompactUnit unit;
@@ -0,0 +1,169 @@
+#ifndef DATRIE_PACKED_SERIALIZER
+#define DATRIE_PACKED_SERIALIZER
+
+#include "format.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xtrie {
+
+//! @brief Packed serializer will save the units bit-packed by blocks, for
+//! PackedDoubleArrayTrie
+//!
+//!     Every block of BlockSize units has a reference base, the smallest
+//!     non zero base of the block, and the units are stored at the width of
+//!     the largest of the block: base - reference + 1 (0 for a base of 0),
+//!     then check, at the width of the largest mapped char of the trie.
+//!
+//!     The payload is 6 words: number of units, width of check, log2 of
+//!     BlockSize, number of blocks, size of the packed units, size of a
+//!     value, then one directory entry per block: reference << 8 | width,
+//!     and the byte offset of its units. The packed units are padded so
+//!     that 8 bytes can be read from any unit. The values follow, one per
+//!     unit as DefaultSerializer saves them, 4 or 8 bytes each, the files
+//!     of 8-byte values are TrieFormat::PACKED64.
+//!
+//!     base value must be less than 2^24.
+template <uint32_t BlockSize = 64> struct PackedSerializer {
+  static_assert(BlockSize == 64 || BlockSize == 256);
+
+  static constexpr TrieFormat FORMAT = TrieFormat::PACKED;
+
+  //! measures the blocks, only operator() packs them
+  template <typename Units, typename Values, typename T>
+  size_t get_size(const Units &base, const Units &check, const Values &,
+                  T) const {
+    size_t n = base.size();
+    auto check_width = get_check_width(check);
+
+    size_t units_size = 0;
+    for (size_t first = 0; first < n; first += BlockSize) {
+      size_t last = std::min(n, first + BlockSize);
+      auto block = get_block(base, first, last, check_width);
+      units_size += ((last - first) * block.width + 7) / 8;
+    }
+
+    size_t n_blocks = (n + BlockSize - 1) / BlockSize;
+    return sizeof(uint32_t) * (HEADER_SIZE + 2 * n_blocks) +
+           padded(units_size);
+  }
+
+  template <typename OStream, typename Units, typename Values, typename T>
+  void operator()(OStream &os, const Units &base, const Units &check,
+                  const Values &value, T) const {
+    static_assert(sizeof(T) == sizeof(uint32_t) ||
+                  sizeof(T) == sizeof(uint64_t));
+
+    auto packed = pack(base, check, sizeof(T));
+    os.write(reinterpret_cast<const char *>(packed.header),
+             sizeof(packed.header));
+    os.write(reinterpret_cast<const char *>(packed.directory.data()),
+             sizeof(uint32_t) * packed.directory.size());
+    os.write(packed.units.data(), packed.units.size());
+
+    for (size_t i = 0; i < base.size(); ++i) {
+      os.write(reinterpret_cast<const char *>(&value[i]), sizeof(T));
+    }
+  }
+
+private:
+  static constexpr size_t HEADER_SIZE = 6;
+
+  struct Packed {
+    uint32_t header[HEADER_SIZE];
+    std::vector<uint32_t> directory; // 2 words per block
+    std::string units;
+  };
+
+  struct Block {
+    uint64_t ref;
+    uint32_t width;
+  };
+
+  //! 8 bytes can be read from the last unit, the values stay aligned
+  static size_t padded(size_t units_size) {
+    return (units_size + 8 + 7) / 8 * 8;
+  }
+
+  template <typename Units>
+  static uint32_t get_check_width(const Units &check) {
+    int64_t max_check = 0;
+    for (size_t i = 0; i < check.size(); ++i) {
+      max_check = std::max(max_check, static_cast<int64_t>(check[i]));
+    }
+    return static_cast<uint32_t>(
+        std::bit_width(static_cast<uint64_t>(max_check)));
+  }
+
+  template <typename Units>
+  static Block get_block(const Units &base, size_t first, size_t last,
+                         uint32_t check_width) {
+    uint64_t ref = 0;
+    for (size_t i = first; i < last; ++i) {
+      assert(base[i] >= 0 && base[i] < (1 << 24));
+      auto b = static_cast<uint64_t>(base[i]);
+      if (b != 0 && (ref == 0 || b < ref))
+        ref = b;
+    }
+
+    uint64_t max_delta = 0;
+    for (size_t i = first; i < last; ++i) {
+      if (base[i] != 0)
+        max_delta =
+            std::max(max_delta, static_cast<uint64_t>(base[i]) - ref + 1);
+    }
+
+    return {ref, static_cast<uint32_t>(std::bit_width(max_delta)) +
+                     check_width};
+  }
+
+  template <typename Units>
+  static Packed pack(const Units &base, const Units &check,
+                     size_t value_size) {
+    size_t n = base.size();
+    size_t n_blocks = (n + BlockSize - 1) / BlockSize;
+    auto check_width = get_check_width(check);
+
+    Packed res;
+    res.directory.reserve(2 * n_blocks);
+
+    for (size_t first = 0; first < n; first += BlockSize) {
+      size_t last = std::min(n, first + BlockSize);
+      auto [ref, width] = get_block(base, first, last, check_width);
+      res.directory.push_back(static_cast<uint32_t>(ref << 8 | width));
+      res.directory.push_back(static_cast<uint32_t>(res.units.size()));
+
+      std::string bytes(((last - first) * width + 7) / 8, '\0');
+      uint64_t bit = 0;
+      for (size_t i = first; i < last; ++i, bit += width) {
+        assert(check[i] < (1 << 8));
+        uint64_t delta =
+            base[i] == 0 ? 0 : static_cast<uint64_t>(base[i]) - ref + 1;
+        uint64_t field = delta << check_width | static_cast<uint64_t>(check[i]);
+        field <<= bit % 8;
+        for (size_t byte = bit / 8; field != 0; ++byte, field >>= 8) {
+          bytes[byte] |= static_cast<char>(field & 0xff);
+        }
+      }
+      res.units += bytes;
+    }
+
+    res.units.resize(padded(res.units.size()), '\0');
+
+    res.header[0] = static_cast<uint32_t>(n);
+    res.header[1] = check_width;
+    res.header[2] = static_cast<uint32_t>(std::countr_zero(BlockSize));
+    res.header[3] = static_cast<uint32_t>(n_blocks);
+    res.header[4] = static_cast<uint32_t>(res.units.size());
+    res.header[5] = static_cast<uint32_t>(value_size);
+    return res;
+  }
+};
+
+} // namespace xtrie
+
+#endif // DATRIE_PACKED_SERIALIZER
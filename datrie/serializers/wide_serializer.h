@@ -0,0 +1,59 @@
+#ifndef DATRIE_WIDE_SERIALIZER
+#define DATRIE_WIDE_SERIALIZER
+
+#include "format.h"
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace xtrie {
+
+//! @brief Wide serializer will save the values, with a 32-bit check
+//!
+//!     For alphabets whose ids don't fit in 8 bits (Utf8Alphabet).
+//!
+//!     32 bit for base, 32 bit for check.
+//!
+//!     values will be saved in another array at the end.
+//!
+struct WideSerializer {
+  static constexpr TrieFormat FORMAT = TrieFormat::WIDE;
+
+  template <typename Units, typename Values, typename T>
+  size_t get_size(const Units &base, const Units &, const Values &, T) const {
+    return (sizeof(WideUnit) + sizeof(T)) * base.size();
+  }
+
+  template <typename OStream, typename Units, typename Values, typename T>
+  void operator()(OStream &os, const Units &base, const Units &check,
+                  const Values &value, T) const {
+    static_assert(sizeof(T) <= sizeof(uint32_t));
+
+    WideUnit unit;
+
+    for (size_t i = 0; i < base.size(); ++i) {
+      assert(base[i] < (1LL << 32) && check[i] < (1LL << 32));
+
+      unit.base = static_cast<uint32_t>(base[i]);
+      unit.check = static_cast<uint32_t>(check[i]);
+
+      os.write(reinterpret_cast<char *>(&unit), sizeof(WideUnit));
+    }
+
+    for (size_t i = 0; i < base.size(); ++i) {
+      os.write(reinterpret_cast<const char *>(&value[i]), sizeof(T));
+    }
+  }
+
+private:
+  struct WideUnit {
+    uint32_t base;
+    uint32_t check;
+  };
+
+  static_assert(sizeof(WideUnit) == sizeof(uint64_t));
+};
+
+} // namespace xtrie
+
+#endif // DATRIE_WIDE_SERIALIZER
@@ -0,0 +1,246 @@
+#ifndef STATIC_DATRIE_H
+#define STATIC_DATRIE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#ifdef ASSERT_CONCEPT
+#include <trie_concepts.h>
+#endif
+
+namespace xtrie {
+
+namespace details {
+struct StaticUnit {
+  int32_t base;
+  int32_t check; // parent state, -1 if free
+};
+
+template <typename T> struct StaticBuild {
+  std::vector<StaticUnit> units;
+  std::vector<T> values;
+};
+
+//! @brief Double array of (key, value) entries, in a constant expression
+//!
+//!     No charmap and no DAWG: a transition is the byte plus 1 and check
+//!     holds the parent state, which is enough for the few hundred keys of
+//!     an embedded dictionary. Bases are placed first fit from the first
+//!     free unit, breadth first.
+template <typename T, T DefaultValue>
+constexpr StaticBuild<T>
+build_static_double_array(std::vector<std::pair<std::string_view, T>> entries) {
+  std::sort(entries.begin(), entries.end(),
+            [](const auto &a, const auto &b) { return a.first < b.first; });
+
+  StaticBuild<T> res;
+  res.units.push_back({0, 0}); // the root is its own parent
+  res.values.push_back(DefaultValue);
+
+  auto grow = [&](size_t n) {
+    if (res.units.size() < n) {
+      res.units.resize(n, StaticUnit{0, -1});
+      res.values.resize(n, DefaultValue);
+    }
+  };
+
+  struct Task {
+    int32_t state;
+    size_t begin; // the entries under the state, in entries
+    size_t end;
+    size_t depth;
+  };
+
+  std::vector<Task> queue{{0, 0, entries.size(), 0}};
+  size_t first_free = 1;
+
+  for (size_t t = 0; t < queue.size(); ++t) {
+    auto task = queue[t];
+
+    // the keys ending here come first in key order
+    size_t i = task.begin;
+    if (i < task.end && entries[i].first.size() == task.depth) {
+      if (i + 1 < task.end && entries[i + 1].first.size() == task.depth)
+        throw "duplicate key";
+      res.values[task.state] = entries[i].second;
+      ++i;
+    }
+
+    std::vector<std::pair<int32_t, size_t>> labels; // (label, first entry)
+    for (; i < task.end; ++i) {
+      auto ch = static_cast<uint8_t>(entries[i].first[task.depth]);
+      int32_t label = static_cast<int32_t>(ch) + 1;
+      if (labels.empty() || labels.back().first != label)
+        labels.push_back({label, i});
+    }
+    if (labels.empty())
+      continue;
+
+    while (first_free < res.units.size() && res.units[first_free].check != -1)
+      ++first_free;
+
+    int32_t base = std::max<int32_t>(
+        1, static_cast<int32_t>(first_free) - labels.front().first);
+    for (;; ++base) {
+      grow(static_cast<size_t>(base + labels.back().first + 1));
+      bool fits = true;
+      for (auto &[label, _] : labels) {
+        fits &= res.units[base + label].check == -1;
+      }
+      if (fits)
+        break;
+    }
+
+    res.units[task.state].base = base;
+    for (size_t k = 0; k < labels.size(); ++k) {
+      int32_t child = base + labels[k].first;
+      res.units[child].check = task.state;
+
+      size_t end = k + 1 < labels.size() ? labels[k + 1].second : task.end;
+      queue.push_back({child, labels[k].second, end, task.depth + 1});
+    }
+  }
+
+  return res;
+}
+
+//! keys of a list of string_view get their index as value
+template <typename T, typename Entries>
+constexpr std::vector<std::pair<std::string_view, T>>
+static_entries(const Entries &list) {
+  std::vector<std::pair<std::string_view, T>> res;
+  size_t i = 0;
+  for (auto &e : list) {
+    if constexpr (std::is_convertible_v<decltype(e), std::string_view>)
+      res.push_back({std::string_view(e), static_cast<T>(i)});
+    else
+      res.push_back({std::string_view(e.first), static_cast<T>(e.second)});
+    ++i;
+  }
+  return res;
+}
+} // namespace details
+
+//! @brief Double array trie built at compile time, see make_static_trie
+//!
+//!     The arrays are std::array members of a literal type, so a
+//!     static constexpr trie lives in the read-only data of the binary: no
+//!     startup cost and no file to load. Every member is constexpr, lookups
+//!     of constant keys fold to constants and the rest inline fully.
+template <typename T, T DefaultValue, size_t Size> class StaticDoubleArrayTrie {
+public:
+  using value_type = T;
+  static constexpr value_type DEFAULT_VALUE = DefaultValue;
+
+  class TraverseResult {
+    friend class StaticDoubleArrayTrie;
+
+  public:
+    constexpr unsigned state() const { return state_index_; }
+    constexpr bool matched() const { return matched_; }
+    constexpr uint32_t matched_length() const { return matched_length_; }
+
+  private:
+    unsigned state_index_;
+    bool matched_;
+    uint32_t matched_length_;
+
+    constexpr TraverseResult(unsigned state_index, bool matched,
+                             uint32_t matched_length)
+        : state_index_(state_index), matched_(matched),
+          matched_length_(matched_length) {}
+  };
+
+  constexpr explicit StaticDoubleArrayTrie(
+      const details::StaticBuild<T> &build) {
+    std::copy(build.units.begin(), build.units.end(), units_.begin());
+    std::copy(build.values.begin(), build.values.end(), values_.begin());
+  }
+
+  constexpr TraverseResult traverse(std::string_view prefix,
+                                    unsigned state_index) const {
+    unsigned p = state_index;
+
+    uint32_t i = 0;
+    for (; i < prefix.size(); ++i) {
+      size_t q = static_cast<size_t>(units_[p].base) +
+                 static_cast<uint8_t>(prefix[i]) + 1;
+      if (q < Size && units_[q].check == static_cast<int32_t>(p)) {
+        p = static_cast<unsigned>(q);
+      } else {
+        return {p, false, i};
+      }
+    }
+    return {p, true, i};
+  }
+
+  constexpr TraverseResult traverse(std::string_view prefix) const {
+    return traverse(prefix, 0);
+  }
+
+  constexpr bool has_value_at(unsigned state_index) const {
+    return values_[state_index] != DEFAULT_VALUE;
+  }
+
+  constexpr const value_type &value_at(unsigned state_index) const {
+    return values_[state_index];
+  }
+
+  //! @brief Value of key, DEFAULT_VALUE if it is not a key
+  constexpr value_type find(std::string_view key) const {
+    auto res = traverse(key);
+    return res.matched() ? values_[res.state()] : DEFAULT_VALUE;
+  }
+
+  constexpr bool contains(std::string_view key) const {
+    return find(key) != DEFAULT_VALUE;
+  }
+
+  //! number of units
+  static constexpr size_t size() { return Size; }
+
+private:
+  std::array<details::StaticUnit, Size> units_{};
+  std::array<value_type, Size> values_{};
+};
+
+//! @brief Build a StaticDoubleArrayTrie from a constant list of entries
+//!
+//!     Entries is a static array of keys, each getting its index in the list
+//!     as value, or of (key, value) pairs:
+//!
+//!         static constexpr std::string_view STOP_WORDS[] = {"a", "the"};
+//!         static constexpr auto stop_words = make_static_trie<STOP_WORDS>();
+//!         static_assert(stop_words.contains("the"));
+//!
+//!     The array is built twice, once to size the std::arrays. A duplicate
+//!     key or a value equal to DefaultValue fails the constant evaluation.
+template <const auto &Entries, typename T = int, T DefaultValue = -1>
+consteval auto make_static_trie() {
+  constexpr size_t size = details::build_static_double_array<T, DefaultValue>(
+                              details::static_entries<T>(Entries))
+                              .units.size();
+
+  auto entries = details::static_entries<T>(Entries);
+  for (auto &[key, value] : entries) {
+    if (value == DefaultValue)
+      throw "a value equals the default value";
+  }
+
+  return StaticDoubleArrayTrie<T, DefaultValue, size>(
+      details::build_static_double_array<T, DefaultValue>(entries));
+}
+
+#ifdef ASSERT_CONCEPT
+static_assert(IsKVTrie<StaticDoubleArrayTrie<int, -1, 1>>);
+#endif
+
+} // namespace xtrie
+
+#endif // STATIC_DATRIE_H
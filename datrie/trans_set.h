@@ -0,0 +1,258 @@
+#ifndef DATRIE_TRANS_SET_H
+#define DATRIE_TRANS_SET_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+#ifdef _WINDOWS
+#include <intrin.h>
+
+#pragma intrinsic(_BitScanForward64)
+#pragma intrinsic(_BitScanReverse64)
+#endif
+
+namespace xtrie {
+
+namespace details {
+static inline unsigned char _bit_scan_forward(unsigned long *index,
+                                              uint64_t data) {
+  if (data == 0)
+    return 0;
+
+  unsigned long res = 0;
+
+  do {
+    if (data & 1) {
+      *index = res;
+      return 1;
+    }
+
+    data >>= 1;
+    ++res;
+  } while (data > 0);
+
+  assert(false);
+  return 1;
+}
+
+static inline unsigned char bit_scan_forward(unsigned long *index,
+                                             uint64_t data) {
+#ifdef _WINDOWS
+  return _BitScanForward64(index, data);
+#else
+  return _bit_scan_forward(index, data);
+#endif
+}
+
+static inline unsigned char _bit_scan_reverse(unsigned long *index,
+                                              uint64_t data) {
+  if (data == 0)
+    return 0;
+
+  unsigned long res = 0;
+
+  do {
+    if (data & (1ULL << 63)) {
+      *index = 63 - res;
+      return 1;
+    }
+
+    data <<= 1;
+    ++res;
+  } while (data > 0);
+
+  assert(false);
+  return 1;
+}
+
+static inline unsigned char bit_scan_reverse(unsigned long *index,
+                                             uint64_t data) {
+#ifdef _WINDOWS
+  return _BitScanReverse64(index, data);
+#else
+  return _bit_scan_reverse(index, data);
+#endif
+}
+} // namespace details
+
+class TransSet {
+public:
+  class Iterator {
+  public:
+    Iterator(const uint64_t *data)
+        : iter_data_{data[0], data[1], data[2], data[3]} {}
+
+    bool end() {
+      return iter_data_[0] == 0 && iter_data_[1] == 0 && iter_data_[2] == 0 &&
+             iter_data_[3] == 0;
+    }
+
+    Iterator &operator++() {
+      using namespace details;
+
+      unsigned long index = 0;
+
+      if (bit_scan_forward(&index, iter_data_[0])) {
+        iter_data_[0] &= ~(1ULL << index);
+      } else if (bit_scan_forward(&index, iter_data_[1])) {
+        iter_data_[1] &= ~(1ULL << index);
+      } else if (bit_scan_forward(&index, iter_data_[2])) {
+        iter_data_[2] &= ~(1ULL << index);
+      } else if (bit_scan_forward(&index, iter_data_[3])) {
+        iter_data_[3] &= ~(1ULL << index);
+      }
+
+      return *this;
+    }
+
+    unsigned long trans() const {
+      using namespace details;
+
+      unsigned long index = 0;
+
+      if (bit_scan_forward(&index, iter_data_[0])) {
+        return index;
+      } else if (bit_scan_forward(&index, iter_data_[1])) {
+        return index + 64;
+      } else if (bit_scan_forward(&index, iter_data_[2])) {
+        return index + 64 * 2;
+      } else if (bit_scan_forward(&index, iter_data_[3])) {
+        return index + 64 * 3;
+      }
+
+      return 0; // invalid, no trans
+    }
+
+  private:
+    uint64_t iter_data_[4];
+  };
+
+public:
+  TransSet() : data_{0, 0, 0, 0} {}
+
+  void add(uint8_t ch) {
+    if (ch < 64) {
+      data_[0] |= (1ULL << ch);
+    } else if (ch < 64 * 2) {
+      data_[1] |= (1ULL << (ch - 64));
+    } else if (ch < 64 * 3) {
+      data_[2] |= (1ULL << (ch - 64 * 2));
+    } else {
+      data_[3] |= (1ULL << (ch - 64 * 3));
+    }
+  }
+
+  const uint64_t *data() const { return data_; }
+
+  bool empty() const {
+    return data_[0] == 0 && data_[1] == 0 && data_[2] == 0 && data_[3] == 0;
+  }
+
+  bool has(uint8_t ch) const {
+    if (ch < 64) {
+      return data_[0] & (1ULL << ch);
+    } else if (ch < 64 * 2) {
+      return data_[1] & (1ULL << (ch - 64));
+    } else if (ch < 64 * 3) {
+      return data_[2] & (1ULL << (ch - 64 * 2));
+    } else {
+      return data_[3] & (1ULL << (ch - 64 * 3));
+    }
+  }
+
+  Iterator begin() const { return {data_}; }
+
+  unsigned long front() const {
+    using namespace details;
+
+    unsigned long index = 0;
+
+    if (bit_scan_forward(&index, data_[0])) {
+      return index;
+    } else if (bit_scan_forward(&index, data_[1])) {
+      return index + 64;
+    } else if (bit_scan_forward(&index, data_[2])) {
+      return index + 64 * 2;
+    } else if (bit_scan_forward(&index, data_[3])) {
+      return index + 64 * 3;
+    }
+
+    return 0; // invalid, no trans
+  }
+
+  unsigned long back() const {
+    using namespace details;
+
+    unsigned long index = 0;
+
+    if (bit_scan_reverse(&index, data_[3])) {
+      return index + 64 * 3;
+    } else if (bit_scan_reverse(&index, data_[2])) {
+      return index + 64 * 2;
+    } else if (bit_scan_reverse(&index, data_[1])) {
+      return index + 64;
+    } else if (bit_scan_reverse(&index, data_[0])) {
+      return index;
+    }
+
+    return 0; // invalid, no trans
+  }
+
+private:
+  uint64_t data_[4];
+};
+
+//! @brief Transition set for alphabets wider than a byte
+//!
+//!     Same interface as TransSet, but backed by a sorted vector because the
+//!     labels of a code point alphabet don't fit into a bitmap.
+class SymbolSet {
+public:
+  class Iterator {
+  public:
+    Iterator(const uint32_t *begin, const uint32_t *end)
+        : iter_(begin), end_(end) {}
+
+    bool end() { return iter_ == end_; }
+
+    Iterator &operator++() {
+      ++iter_;
+      return *this;
+    }
+
+    unsigned long trans() const { return *iter_; }
+
+  private:
+    const uint32_t *iter_;
+    const uint32_t *end_;
+  };
+
+public:
+  void add(uint32_t ch) {
+    auto it = std::lower_bound(data_.begin(), data_.end(), ch);
+    if (it == data_.end() || *it != ch)
+      data_.insert(it, ch);
+  }
+
+  bool empty() const { return data_.empty(); }
+
+  bool has(uint32_t ch) const {
+    return std::binary_search(data_.begin(), data_.end(), ch);
+  }
+
+  Iterator begin() const {
+    return {data_.data(), data_.data() + data_.size()};
+  }
+
+  unsigned long front() const { return data_.empty() ? 0 : data_.front(); }
+  unsigned long back() const { return data_.empty() ? 0 : data_.back(); }
+
+private:
+  std::vector<uint32_t> data_;
+};
+
+} // namespace xtrie
+
+#endif // DATRIE_TRANS_SET_H
@@ -0,0 +1,141 @@
+#ifndef DATRIE_UTF8_H
+#define DATRIE_UTF8_H
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace xtrie {
+
+namespace utf8 {
+
+static constexpr uint32_t MAX_CODE_POINT = 0x10FFFF;
+
+//! Bytes which are not part of a well-formed sequence are decoded to
+//! RAW_BYTE_BASE + byte, so that every byte string has exactly one decoding
+//! and keys with broken encodings can still be stored.
+static constexpr uint32_t RAW_BYTE_BASE = MAX_CODE_POINT + 1;
+static constexpr uint32_t MAX_SYMBOL = RAW_BYTE_BASE + 0xFF;
+
+static inline uint32_t sequence_length(uint8_t lead) {
+  if (lead < 0x80)
+    return 1;
+  if (lead < 0xC2) // continuation byte or overlong 2-byte lead
+    return 0;
+  if (lead < 0xE0)
+    return 2;
+  if (lead < 0xF0)
+    return 3;
+  if (lead < 0xF5)
+    return 4;
+  return 0;
+}
+
+static inline bool is_continuation(uint8_t ch) { return (ch & 0xC0) == 0x80; }
+
+//! @brief Decode the symbol at the head of s[0, n)
+//!
+//!     Overlong forms and code points beyond U+10FFFF are rejected, otherwise
+//!     two byte strings could decode to the same symbol.
+//!
+//! @param len receives the number of bytes consumed
+static inline uint32_t decode(const char *s, size_t n, uint32_t &len) {
+  assert(n > 0);
+
+  uint8_t lead = static_cast<uint8_t>(s[0]);
+  uint32_t seq = sequence_length(lead);
+
+  len = 1;
+  if (seq == 1)
+    return lead;
+
+  if (seq == 0 || seq > n)
+    return RAW_BYTE_BASE + lead;
+
+  uint32_t cp = lead & (0x7F >> seq);
+  for (uint32_t i = 1; i < seq; ++i) {
+    uint8_t ch = static_cast<uint8_t>(s[i]);
+    if (!is_continuation(ch))
+      return RAW_BYTE_BASE + lead;
+
+    cp = (cp << 6) | (ch & 0x3F);
+  }
+
+  constexpr uint32_t min_code_point[5] = {0, 0, 0x80, 0x800, 0x10000};
+  if (cp < min_code_point[seq] || cp > MAX_CODE_POINT)
+    return RAW_BYTE_BASE + lead;
+
+  len = seq;
+  return cp;
+}
+
+//! @brief Length of the leading run of ASCII bytes, 8 bytes at a time
+static inline size_t ascii_prefix_length(const char *s, size_t n) {
+  constexpr uint64_t high_bits = 0x8080808080808080ULL;
+
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= n; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, s + i, sizeof(uint64_t));
+    if (word & high_bits)
+      break;
+  }
+
+  while (i < n && static_cast<uint8_t>(s[i]) < 0x80)
+    ++i;
+
+  return i;
+}
+
+//! @brief Two-stage lookup table from symbol to dense id
+//!
+//!     The first stage is indexed by the high bits of the symbol and selects
+//!     a block of 256 ids, blocks without any mapped symbol share block 0.
+//!     CJK text touches a few dozen blocks, so the table stays in L2.
+class SymbolTable {
+public:
+  //! symbols[i] is mapped to id i + 1, 0 is kept for unknown symbols
+  void assign(const std::vector<uint32_t> &symbols) {
+    index_.assign((MAX_SYMBOL >> BLOCK_BITS) + 1, 0);
+    blocks_.assign(BLOCK_SIZE, 0);
+
+    for (uint32_t i = 0; i < symbols.size(); ++i) {
+      assert(symbols[i] <= MAX_SYMBOL);
+
+      auto &block = index_[symbols[i] >> BLOCK_BITS];
+      if (block == 0) {
+        block = static_cast<uint16_t>(blocks_.size() / BLOCK_SIZE);
+        blocks_.resize(blocks_.size() + BLOCK_SIZE, 0);
+      }
+
+      blocks_[block * BLOCK_SIZE + (symbols[i] & BLOCK_MASK)] = i + 1;
+    }
+  }
+
+  uint32_t operator[](uint32_t symbol) const {
+    assert(symbol <= MAX_SYMBOL);
+    return blocks_[index_[symbol >> BLOCK_BITS] * BLOCK_SIZE +
+                   (symbol & BLOCK_MASK)];
+  }
+
+  size_t memory_size() const {
+    return index_.size() * sizeof(uint16_t) + blocks_.size() * sizeof(uint32_t);
+  }
+
+private:
+  static constexpr uint32_t BLOCK_BITS = 8;
+  static constexpr uint32_t BLOCK_SIZE = 1 << BLOCK_BITS;
+  static constexpr uint32_t BLOCK_MASK = BLOCK_SIZE - 1;
+
+  static_assert((MAX_SYMBOL >> BLOCK_BITS) < (1 << 16));
+
+  std::vector<uint16_t> index_;
+  std::vector<uint32_t> blocks_;
+};
+
+} // namespace utf8
+
+} // namespace xtrie
+
+#endif // DATRIE_UTF8_H
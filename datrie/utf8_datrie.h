@@ -0,0 +1,179 @@
+#ifndef UTF8_DATRIE_H
+#define UTF8_DATRIE_H
+
+#include "serializers/format.h"
+#include "utf8.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#ifdef ASSERT_CONCEPT
+#include <trie_concepts.h>
+#endif
+
+namespace xtrie {
+
+//! @brief Double array trie whose transitions are UTF-8 code points
+//!
+//!     Loads what DoubleArrayTrieBuilder<..., Utf8Alphabet> saves with
+//!     WideSerializer.
+//!
+//!     The query is decoded to ids chunk by chunk before walking the array,
+//!     so the dependent loads of the walk are not interleaved with decoding.
+//!     Runs of ASCII are mapped 8 bytes at a time.
+//!
+//! @tparam Allocator of the arrays, std::allocator or HugePageAllocator
+template <typename T = int, T DefaultValue = -1,
+          template <typename> class Allocator = std::allocator>
+class Utf8DoubleArrayTrie {
+public:
+  using value_type = T;
+  static constexpr value_type DEFAULT_VALUE = DefaultValue;
+
+  class TraverseResult {
+    friend class Utf8DoubleArrayTrie;
+
+  public:
+    unsigned state() const { return state_index_; }
+    bool matched() const { return matched_; }
+    uint32_t matched_length() const { return matched_length_; }
+
+  private:
+    unsigned state_index_;
+    bool matched_;
+    uint32_t matched_length_;
+
+    TraverseResult(unsigned state_index, bool matched, uint32_t matched_length)
+        : state_index_(state_index), matched_(matched),
+          matched_length_(matched_length) {}
+  };
+
+public:
+  template <typename IStream> void load(IStream &is) {
+
+    uint32_t size_sum;
+    [[maybe_unused]] auto format = read_format_header(is, size_sum);
+    assert(format == TrieFormat::UNKNOWN || format == TrieFormat::WIDE);
+
+    uint32_t n_symbols;
+    is.read(reinterpret_cast<char *>(&n_symbols), sizeof(uint32_t));
+
+    symbols_.resize(n_symbols);
+    is.read(reinterpret_cast<char *>(symbols_.data()),
+            sizeof(uint32_t) * n_symbols);
+
+    uint32_t charmap_size = sizeof(uint32_t) * (n_symbols + 1);
+    assert(size_sum > charmap_size);
+
+    size_sum -= charmap_size;
+    bases_.resize(size_sum / (sizeof(WideUnit) + sizeof(value_type)));
+    values_.resize(bases_.size());
+
+    is.read(reinterpret_cast<char *>(bases_.data()),
+            sizeof(WideUnit) * bases_.size());
+
+    for (size_t i = 0; i < values_.size(); ++i) {
+      is.read(reinterpret_cast<char *>(&values_[i]), sizeof(value_type));
+    }
+
+    table_.assign(symbols_);
+    for (uint32_t ch = 0; ch < 0x80; ++ch) {
+      ascii_ids_[ch] = table_[ch];
+    }
+  }
+
+  TraverseResult traverse(std::string_view prefix, unsigned state_index) const {
+    unsigned p = state_index;
+
+    uint32_t ids[CHUNK_SIZE];
+    uint32_t ends[CHUNK_SIZE]; // byte offset after each decoded symbol
+
+    uint32_t i = 0;
+    while (i < prefix.size()) {
+      uint32_t n = decode_chunk(prefix, i, ids, ends);
+
+      for (uint32_t k = 0; k < n; ++k) {
+        unsigned new_base = bases_[p].base + ids[k];
+        if (ids[k] != 0 && new_base < bases_.size() &&
+            bases_[new_base].check == ids[k]) {
+          p = new_base;
+        } else {
+          return {p, false, k == 0 ? i : ends[k - 1]};
+        }
+      }
+
+      i = ends[n - 1];
+    }
+    return {p, true, i};
+  }
+
+  TraverseResult traverse(std::string_view prefix) const {
+    return traverse(prefix, 0);
+  }
+
+  //! number of units, the used ones and the free ones
+  size_t n_units() const { return bases_.size(); }
+
+  bool has_value_at(unsigned state_index) const {
+    return values_[state_index] != DEFAULT_VALUE;
+  }
+
+  const value_type &value_at(unsigned state_index) const {
+    return values_[state_index];
+  }
+
+  value_type &value_at(unsigned state_index) { return values_[state_index]; }
+
+private:
+  static constexpr uint32_t CHUNK_SIZE = 64;
+
+  struct WideUnit {
+    uint32_t base;
+    uint32_t check;
+  };
+
+  static_assert(sizeof(WideUnit) == sizeof(uint64_t));
+
+  //! @brief Decode up to CHUNK_SIZE symbols of s starting from byte i
+  //! @return the number of decoded symbols, at least 1
+  uint32_t decode_chunk(std::string_view s, uint32_t i, uint32_t *ids,
+                        uint32_t *ends) const {
+    uint32_t n = 0;
+    while (n < CHUNK_SIZE && i < s.size()) {
+      size_t ascii = utf8::ascii_prefix_length(
+          s.data() + i, std::min<size_t>(s.size() - i, CHUNK_SIZE - n));
+      for (size_t k = 0; k < ascii; ++k) {
+        ids[n] = ascii_ids_[static_cast<uint8_t>(s[i])];
+        ends[n++] = ++i;
+      }
+
+      if (n == CHUNK_SIZE || i == s.size())
+        break;
+
+      uint32_t len;
+      ids[n] = table_[utf8::decode(s.data() + i, s.size() - i, len)];
+      i += len;
+      ends[n++] = i;
+    }
+    return n;
+  }
+
+  std::vector<uint32_t> symbols_; // symbol of id i + 1
+  utf8::SymbolTable table_;
+  uint32_t ascii_ids_[0x80];
+
+  std::vector<WideUnit, Allocator<WideUnit>> bases_;
+  std::vector<value_type, Allocator<value_type>> values_;
+};
+
+#ifdef ASSERT_CONCEPT
+static_assert(IsDeserializableTrie<Utf8DoubleArrayTrie<>>);
+static_assert(IsKVTrie<Utf8DoubleArrayTrie<>>);
+#endif
+
+} // namespace xtrie
+
+#endif // UTF8_DATRIE_H
@@ -0,0 +1,72 @@
+#ifndef DATRIE_VALUE_LAYOUT_H
+#define DATRIE_VALUE_LAYOUT_H
+
+#include <cstddef>
+#include <vector>
+
+namespace xtrie {
+
+//! @brief Layout of DefaultDoubleArrayTrie: the units and the values in two
+//! arrays
+//!
+//!     The walk only reads units, 4 bytes each, so 16 of them share a cache
+//!     line. A hit then reads its value from the other array, one more miss.
+struct SplitLayout {
+  template <typename Unit, typename T, template <typename> class Allocator>
+  class Array {
+  public:
+    size_t size() const { return units_.size(); }
+
+    void resize(size_t n) {
+      units_.resize(n);
+      values_.resize(n);
+    }
+
+    Unit &unit(size_t i) { return units_[i]; }
+    const Unit &unit(size_t i) const { return units_[i]; }
+
+    T &value(size_t i) { return values_[i]; }
+    const T &value(size_t i) const { return values_[i]; }
+
+  private:
+    std::vector<Unit, Allocator<Unit>> units_;
+    std::vector<T, Allocator<T>> values_;
+  };
+};
+
+//! @brief Layout of DefaultDoubleArrayTrie: every value next to its unit
+//!
+//!     A unit and its value make one record, 8 bytes with 32-bit values and
+//!     16 bytes with 64-bit ones, so the value of the state a walk ends at
+//!     comes with the cache line of its unit. The walk reads fewer units per
+//!     line in exchange.
+struct InterleavedLayout {
+  template <typename Unit, typename T, template <typename> class Allocator>
+  class Array {
+  public:
+    size_t size() const { return records_.size(); }
+
+    void resize(size_t n) { records_.resize(n); }
+
+    Unit &unit(size_t i) { return records_[i].unit; }
+    const Unit &unit(size_t i) const { return records_[i].unit; }
+
+    T &value(size_t i) { return records_[i].value; }
+    const T &value(size_t i) const { return records_[i].value; }
+
+  private:
+    struct Record {
+      Unit unit;
+      T value;
+    };
+
+    // records never straddle two cache lines
+    static_assert(64 % sizeof(Record) == 0);
+
+    std::vector<Record, Allocator<Record>> records_;
+  };
+};
+
+} // namespace xtrie
+
+#endif // DATRIE_VALUE_LAYOUT_H
@@ -4,11 +4,14 @@
 #include <algorithm>
 #include <cassert>
 #include <iostream>
+#include <levenshtein.h>
 #include <memory>
 #include <queue>
+#include <radix_sort.h>
 #include <stack>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -170,6 +173,24 @@ public:
 
   const value_type &value_at(const Node *state) const { return state->value(); }
 
+  //! @brief Enumerate the transitions of a state
+  //!
+  //! @param f called as f(char, child state) in no particular order
+  template <typename F> void for_each_child(const Node *state, F &&f) const {
+    for (auto it = state->trans_begin(); it != state->trans_end(); ++it) {
+      f(it.key(), it.target());
+    }
+  }
+
+  //! @brief Find the keys within max_edits byte edits of query
+  //!
+  //! @param f called as f(key, state, distance) in no particular order
+  template <typename F>
+  void fuzzy_search(std::string_view query, uint32_t max_edits, F &&f) const {
+    levenshtein_walk(LevenshteinAutomaton(query, max_edits), *this, &root_,
+                     f);
+  }
+
   void add(std::string_view sv, T value) {
     size_t current_prefix_size = build_->current_prefix_.size();
 
@@ -206,6 +227,19 @@ public:
     p->value() = value;
   }
 
+  //! @brief Add (key, value) pairs in any order
+  //!
+  //!     add() needs the keys sorted, these are sorted by radix_sort_order
+  //!     first. A key given more than once keeps its first value. The keys
+  //!     must come after the ones added before.
+  template <typename Range>
+  void add_bulk(const Range &pairs,
+                unsigned n_threads = std::thread::hardware_concurrency()) {
+    for_each_sorted_unique<T>(
+        pairs, [&](std::string_view key, T value) { add(key, value); },
+        n_threads);
+  }
+
   void end_build() {
     minimize(0);
     build_.reset();
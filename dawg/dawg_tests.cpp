@@ -1,6 +1,13 @@
 ﻿#include "dawg.h"
 #include <boost/ut.hpp>
 #include <iostream>
+#include <pattern.h>
+#include <random>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include <workload.h>
 #include <testcases.h>
 
 int main() {
@@ -41,6 +48,134 @@ int main() {
     expect(node_he == node_me);
   };
 
+  "test radix sort"_test = [] {
+    std::mt19937 rng(42);
+    std::vector<std::string> strings;
+    for (int i = 0; i < 200000; ++i) {
+      // few letters, many shared prefixes and duplicates
+      std::string s(rng() % 12, 'a');
+      for (auto &ch : s) {
+        ch = static_cast<char>(rng() % 3 ? 'a' + rng() % 4 : 0x80 + rng() % 4);
+      }
+      strings.push_back(std::move(s));
+    }
+    std::vector<std::string_view> keys(strings.begin(), strings.end());
+
+    std::vector<uint32_t> expected(keys.size());
+    for (uint32_t i = 0; i < expected.size(); ++i) {
+      expected[i] = i;
+    }
+    std::stable_sort(expected.begin(), expected.end(),
+                     [&](uint32_t a, uint32_t b) { return keys[a] < keys[b]; });
+
+    expect(radix_sort_order(keys, 1) == expected);
+    expect(radix_sort_order(keys, 4) == expected);
+    expect(radix_sort_order({}, 4).empty());
+  };
+
+  "test add_bulk"_test = [] {
+    std::vector<std::pair<std::string, int>> pairs{
+        {"mello", 1}, {"hi", 2}, {"hello", 3}, {"hi", 4}, {"h", 5}};
+
+    DAWG dawg;
+    dawg.add_bulk(pairs, 2);
+    dawg.end_build();
+
+    auto value_of = [&](std::string_view key) {
+      auto res = dawg.traverse(key);
+      return res.matched() ? dawg.value_at(res.state()) : -1;
+    };
+    expect(value_of("h") == 5);
+    expect(value_of("hi") == 2); // the first of the duplicates
+    expect(value_of("hello") == 3);
+    expect(value_of("mello") == 1);
+  };
+
+  "test fuzzy search"_test = [] {
+    auto full_distance = [](std::string_view a, std::string_view b) {
+      std::vector<uint32_t> row(b.size() + 1);
+      for (uint32_t j = 0; j <= b.size(); ++j) {
+        row[j] = j;
+      }
+      for (size_t i = 1; i <= a.size(); ++i) {
+        uint32_t diag = row[0];
+        row[0] = static_cast<uint32_t>(i);
+        for (size_t j = 1; j <= b.size(); ++j) {
+          uint32_t up = row[j];
+          row[j] = std::min({row[j] + 1, row[j - 1] + 1,
+                             diag + (a[i - 1] != b[j - 1] ? 1u : 0u)});
+          diag = up;
+        }
+      }
+      return row[b.size()];
+    };
+
+    std::mt19937 rng(7);
+    bool all_equal = true;
+    for (int i = 0; i < 2000; ++i) {
+      std::string a(rng() % 8, 'a'), b(rng() % 8, 'a');
+      for (auto *s : {&a, &b}) {
+        for (auto &ch : *s) {
+          ch = static_cast<char>('a' + rng() % 3);
+        }
+      }
+      for (uint32_t k = 0; k <= 3; ++k) {
+        all_equal &= LevenshteinAutomaton(a, k).distance_to(b) ==
+                     std::min(full_distance(a, b), k + 1);
+      }
+    }
+    expect(all_equal);
+
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    std::sort(words.begin(), words.end());
+
+    DAWG dawg;
+    for (auto &w : words) {
+      dawg.add(w, 1);
+    }
+    dawg.end_build();
+
+    for (auto &q : typo_queries(words, 50, 2)) {
+      std::vector<std::string> expected, found;
+      for (auto &w : words) {
+        if (full_distance(q, w) <= 2)
+          expected.push_back(w);
+      }
+
+      dawg.fuzzy_search(q, 2, [&](std::string_view key, auto, uint32_t d) {
+        found.emplace_back(key);
+        all_equal &= d == full_distance(q, key);
+      });
+      std::sort(found.begin(), found.end());
+      all_equal &= found == expected;
+    }
+    expect(all_equal);
+  };
+
+  "test pattern match"_test = [] {
+    auto words = load_lexicon(DATA_DIR "en_1k.txt");
+    std::sort(words.begin(), words.end());
+
+    DAWG dawg;
+    for (auto &w : words) {
+      dawg.add(w, 1);
+    }
+    dawg.end_build();
+
+    auto dfa = *PatternDfa::regex("[0-9]+-?[a-z]*");
+    std::vector<std::string> expected, found;
+    for (auto &w : words) {
+      if (dfa.matches(w))
+        expected.push_back(w);
+    }
+    for (auto &m : match_pattern(dawg, dfa)) {
+      found.emplace_back(m.key);
+    }
+    std::sort(found.begin(), found.end());
+    expect(!expected.empty());
+    expect(found == expected);
+  };
+
   add_common_tests<DAWG<>>();
   add_common_tests<DAWG<>>(true);
 
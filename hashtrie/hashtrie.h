@@ -21,7 +21,7 @@ public:
 
   class Node {
   public:
-    using value_type = value_type;
+    using value_type = T;
     using trans_type = std::unordered_map<char, std::unique_ptr<Node>>;
 
   private:
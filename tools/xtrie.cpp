@@ -0,0 +1,623 @@
+#include <algorithm>
+#include <any_trie.h>
+#include <benchmark.h>
+#include <chrono>
+#include <compact_datrie.h>
+#include <cstdio>
+#include <cstdlib>
+#include <datrie_builder.h>
+#include <dawg_datrie_builder.h>
+#include <default_datrie.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <loader.h>
+#include <no_value_datrie.h>
+#include <packed_datrie.h>
+#include <serializers/compact_serializer.h>
+#include <serializers/default_serializer.h>
+#include <serializers/format.h>
+#include <serializers/no_value_serializer.h>
+#include <serializers/packed_serializer.h>
+#include <serializers/wide_serializer.h>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utf8_datrie.h>
+#include <utility>
+#include <vector>
+#include <workload.h>
+
+using namespace xtrie;
+using namespace xtrie::bench;
+
+namespace {
+
+struct Options {
+  std::string command;
+  std::vector<std::string> paths;
+
+  // build
+  TrieFormat format = TrieFormat::DEFAULT;
+  unsigned n_threads = std::thread::hardware_concurrency();
+  std::string report; // JSON build report, none if empty
+
+  // lookup
+  size_t batch_size = 4096;
+
+  // bench
+  std::string lexicon; // keys of the trie if empty
+  size_t repetitions = 5;
+  size_t n_queries = 100000;
+  uint32_t fuzzy = 0; // max edits, no fuzzy search if 0
+  Format report_format = Format::Table;
+  bool counters = true;
+};
+
+[[noreturn]] void usage(const char *argv0) {
+  fprintf(stderr,
+          "usage: %s build [--format FORMAT] [--threads N] [--report JSON]\n"
+          "                  LEXICON OUTPUT\n"
+          "       %s stats TRIE\n"
+          "       %s lookup [--batch N] TRIE < KEYS\n"
+          "       %s bench [--lexicon LEXICON] [--reps N] [--queries N]\n"
+          "                  [--fuzzy MAX_EDITS] [--format table|csv|json]\n"
+          "                  [--no-counters] TRIE\n"
+          "\n"
+          "build   builds a lexicon of \"key\" or \"key\\tvalue\" lines, keys\n"
+          "        without value get their line number, FORMAT is default,\n"
+          "        compact (values below 2^22), no_value, wide (UTF-8 code\n"
+          "        points), dawg (a double array over the minimal DAWG),\n"
+          "        packed (units bit-packed by blocks) or default64 and\n"
+          "        packed64 (64-bit values), a value out of the range of\n"
+          "        FORMAT fails the build, --report writes the timings and\n"
+          "        metrics of the build to JSON\n"
+          "stats   prints the sizes, the fill rate and the depth and fanout\n"
+          "        histograms of a saved trie\n"
+          "lookup  prints \"key\\tvalue\" for every line of stdin, \"-\" as\n"
+          "        the value of a miss\n"
+          "bench   times lookups of hits drawn from a Zipf distribution and\n"
+          "        of misses, and fuzzy searches of typos, the queries come\n"
+          "        from the keys of the trie or from LEXICON\n",
+          argv0, argv0, argv0, argv0);
+  exit(1);
+}
+
+[[noreturn]] void fail(const char *message, const std::string &path) {
+  fprintf(stderr, "%s: %s\n", path.c_str(), message);
+  exit(1);
+}
+
+const char *format_name(TrieFormat format) {
+  switch (format) {
+  case TrieFormat::NO_VALUE:
+    return "no_value";
+  case TrieFormat::DEFAULT:
+    return "default";
+  case TrieFormat::DEFAULT64:
+    return "default64";
+  case TrieFormat::COMPACT:
+    return "compact";
+  case TrieFormat::WIDE:
+    return "wide";
+  case TrieFormat::DAWG:
+    return "dawg";
+  case TrieFormat::PACKED:
+    return "packed";
+  case TrieFormat::PACKED64:
+    return "packed64";
+  default:
+    return "unknown";
+  }
+}
+
+Options parse_options(int argc, char **argv) {
+  if (argc < 2)
+    usage(argv[0]);
+
+  Options options;
+  options.command = argv[1];
+
+  for (int i = 2; i < argc; ++i) {
+    auto arg = std::string_view(argv[i]);
+    auto value = [&] {
+      if (i + 1 == argc)
+        usage(argv[0]);
+      return std::string_view(argv[++i]);
+    };
+    auto number = [&] { return std::strtoull(value().data(), nullptr, 10); };
+
+    if (arg == "--format" && options.command == "build") {
+      auto format = value();
+      if (format == "default")
+        options.format = TrieFormat::DEFAULT;
+      else if (format == "default64")
+        options.format = TrieFormat::DEFAULT64;
+      else if (format == "compact")
+        options.format = TrieFormat::COMPACT;
+      else if (format == "no_value")
+        options.format = TrieFormat::NO_VALUE;
+      else if (format == "wide")
+        options.format = TrieFormat::WIDE;
+      else if (format == "dawg")
+        options.format = TrieFormat::DAWG;
+      else if (format == "packed")
+        options.format = TrieFormat::PACKED;
+      else if (format == "packed64")
+        options.format = TrieFormat::PACKED64;
+      else
+        usage(argv[0]);
+    } else if (arg == "--format" && options.command == "bench") {
+      auto format = value();
+      if (format == "table")
+        options.report_format = Format::Table;
+      else if (format == "csv")
+        options.report_format = Format::Csv;
+      else if (format == "json")
+        options.report_format = Format::Json;
+      else
+        usage(argv[0]);
+    } else if (arg == "--threads") {
+      options.n_threads = std::max(1u, static_cast<unsigned>(number()));
+    } else if (arg == "--report") {
+      options.report = value();
+    } else if (arg == "--batch") {
+      options.batch_size = std::max<size_t>(1, number());
+    } else if (arg == "--lexicon") {
+      options.lexicon = value();
+    } else if (arg == "--reps") {
+      options.repetitions = number();
+    } else if (arg == "--queries") {
+      options.n_queries = number();
+    } else if (arg == "--fuzzy") {
+      options.fuzzy = static_cast<uint32_t>(number());
+    } else if (arg == "--no-counters") {
+      options.counters = false;
+    } else if (arg.starts_with("-")) {
+      usage(argv[0]);
+    } else {
+      options.paths.emplace_back(arg);
+    }
+  }
+
+  size_t n_paths = options.command == "build" ? 2 : 1;
+  if (options.paths.size() != n_paths)
+    usage(argv[0]);
+
+  return options;
+}
+
+//! @brief Load the trie saved in path with the runtime of its format
+//!
+//! @param f called as f(trie, format)
+template <typename F> void visit_trie(const std::string &path, F &&f) {
+  std::ifstream is(path, std::ios::binary);
+  if (!is)
+    fail("cannot open", path);
+
+  uint32_t size_sum;
+  auto format = read_format_header(is, size_sum);
+  is.seekg(0);
+
+  auto load = [&]<typename Trie>(Trie trie) {
+    trie.load(is);
+    f(std::as_const(trie), format);
+  };
+
+  switch (format) {
+  case TrieFormat::NO_VALUE:
+    load(NoValueDoubleArrayTrie<>());
+    break;
+  case TrieFormat::DEFAULT:
+    load(DefaultDoubleArrayTrie<>());
+    break;
+  case TrieFormat::DEFAULT64:
+    load(DefaultDoubleArrayTrie<int64_t>());
+    break;
+  case TrieFormat::COMPACT:
+    load(CompactDoubleArrayTrie<>());
+    break;
+  case TrieFormat::WIDE:
+    load(Utf8DoubleArrayTrie<>());
+    break;
+  case TrieFormat::DAWG:
+    load(DawgDoubleArrayTrie<>());
+    break;
+  case TrieFormat::PACKED:
+    load(PackedDoubleArrayTrie<>());
+    break;
+  case TrieFormat::PACKED64:
+    load(PackedDoubleArrayTrie<int64_t>());
+    break;
+  default:
+    fail("unknown format, saved without a format header?", path);
+  }
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+//
+// build
+//
+
+template <typename Builder, typename Serializer>
+void run_build(const Options &options) {
+  using value_type = typename Builder::value_type;
+  constexpr auto MISSING = std::numeric_limits<int64_t>::min();
+
+  // the values of the compact format are the 22-bit base of a unit
+  constexpr bool IS_COMPACT = std::is_same_v<Serializer, CompactSerializer>;
+  constexpr int64_t MIN_VALUE = std::numeric_limits<value_type>::min();
+  constexpr int64_t MAX_VALUE =
+      IS_COMPACT ? (1 << 22) - 1
+                 : static_cast<int64_t>(std::numeric_limits<value_type>::max());
+
+  if constexpr (std::is_void_v<Serializer>) {
+    if (!options.report.empty())
+      fail("no build report for this format", options.report);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+
+  auto &path = options.paths[0];
+  MappedLexicon<int64_t> lexicon(path.c_str(), MISSING, options.n_threads);
+  if (lexicon.empty())
+    fail("no keys", path);
+
+  std::vector<std::pair<std::string_view, value_type>> pairs;
+  pairs.reserve(lexicon.size());
+  size_t n_dropped = 0;
+  for (size_t i = 0; i < lexicon.size(); ++i) {
+    int64_t value = lexicon.values()[i];
+    // no_value files only tell whether a key exists
+    if (value == MISSING || std::is_same_v<Serializer, NoValueSerializer>)
+      value = static_cast<int64_t>(i + 1);
+
+    if (value < MIN_VALUE || value > MAX_VALUE) {
+      auto message = "line " + std::to_string(i + 1) + ": value " +
+                     std::to_string(value) + " out of the range of the " +
+                     format_name(options.format) + " format";
+      fail(message.c_str(), path);
+    }
+
+    // the default value marks the states without a key
+    if (static_cast<value_type>(value) == Builder::DEFAULT_VALUE) {
+      ++n_dropped;
+      continue;
+    }
+    pairs.push_back({lexicon.keys()[i], static_cast<value_type>(value)});
+  }
+  if (n_dropped > 0) {
+    fprintf(stderr, "%zu keys dropped, their value is the default value\n",
+            n_dropped);
+  }
+
+  Builder builder;
+  builder.add_bulk(pairs, options.n_threads);
+  builder.end_build();
+
+  auto &output = options.paths[1];
+  std::ofstream os(output, std::ios::binary);
+  if (!os)
+    fail("cannot create", output);
+  if constexpr (std::is_void_v<Serializer>) {
+    // the dawg builder has its own format and no build report
+    size_t n_bytes = builder.save(os);
+    os.close();
+    if (!os)
+      fail("write error", output);
+
+    fprintf(stderr, "%s: %zu lines, %s format, %zu bytes, %.2f s\n",
+            output.c_str(), lexicon.size(), format_name(options.format),
+            n_bytes, seconds_since(start));
+  } else {
+    auto report = builder.build_report();
+    builder.save(os, Serializer{}, report);
+    os.close();
+    if (!os)
+      fail("write error", output);
+
+    fprintf(stderr,
+            "%s: %zu lines, %s format, %zu bytes, %.2f %% filled, %.2f s\n",
+            output.c_str(), lexicon.size(), format_name(options.format),
+            report.saved_bytes, 100 * report.fill_rate(), seconds_since(start));
+
+    if (!options.report.empty()) {
+      std::ofstream json(options.report);
+      json << report.to_json() << '\n';
+      if (!json)
+        fail("write error", options.report);
+    }
+  }
+}
+
+//
+// stats
+//
+
+//! @brief Shape of a trie, from a walk of every state reachable from root
+struct TrieStats {
+  size_t n_states = 0;
+  size_t n_keys = 0;
+  std::vector<size_t> states_by_depth;
+  std::vector<size_t> keys_by_depth;
+  std::vector<size_t> states_by_fanout; // index: number of children
+};
+
+template <typename Trie> TrieStats collect_stats(const Trie &trie) {
+  using state_type = decltype(trie.traverse("").state());
+  TrieStats res;
+
+  // state, depth
+  std::vector<std::pair<state_type, size_t>> stack{
+      {trie.traverse("").state(), 0}};
+  while (!stack.empty()) {
+    auto [state, depth] = stack.back();
+    stack.pop_back();
+
+    if (res.states_by_depth.size() <= depth) {
+      res.states_by_depth.resize(depth + 1);
+      res.keys_by_depth.resize(depth + 1);
+    }
+    ++res.n_states;
+    ++res.states_by_depth[depth];
+    if (trie.has_value_at(state)) {
+      ++res.n_keys;
+      ++res.keys_by_depth[depth];
+    }
+
+    size_t fanout = 0;
+    trie.for_each_child(state, [&](char, state_type child) {
+      stack.push_back({child, depth + 1});
+      ++fanout;
+    });
+    if (res.states_by_fanout.size() <= fanout)
+      res.states_by_fanout.resize(fanout + 1);
+    ++res.states_by_fanout[fanout];
+  }
+
+  return res;
+}
+
+void print_histogram(const char *header, const std::vector<size_t> &rows,
+                     const std::vector<size_t> *second_column = nullptr) {
+  printf("\n%s\n", header);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    if (rows[i] == 0)
+      continue;
+    printf("%6zu %12zu", i, rows[i]);
+    if (second_column)
+      printf(" %12zu", (*second_column)[i]);
+    printf("\n");
+  }
+}
+
+void run_stats(const Options &options) {
+  auto &path = options.paths[0];
+  std::ifstream is(path, std::ios::binary | std::ios::ate);
+  auto file_size = static_cast<size_t>(is.tellg());
+
+  visit_trie(path, [&](const auto &trie, TrieFormat format) {
+    printf("format     %s\n", format_name(format));
+    printf("file size  %zu bytes\n", file_size);
+    printf("units      %zu\n", trie.n_units());
+
+    auto noop = [](char, auto) {};
+    if constexpr (requires { trie.for_each_child(trie.traverse("").state(),
+                                                 noop); }) {
+      auto s = collect_stats(trie);
+      printf("states     %zu\n", s.n_states);
+      printf("keys       %zu\n", s.n_keys);
+      // the states of a DAWG are paths, the units of a node are shared
+      if (format != TrieFormat::DAWG)
+        printf("fill rate  %.2f %%\n",
+               100.0 * static_cast<double>(s.n_states) /
+                   static_cast<double>(std::max<size_t>(1, trie.n_units())));
+      printf("bytes/key  %.2f\n", static_cast<double>(file_size) /
+                                      std::max<size_t>(1, s.n_keys));
+
+      print_histogram(" depth       states         keys", s.states_by_depth,
+                      &s.keys_by_depth);
+      print_histogram("fanout       states", s.states_by_fanout);
+    } else {
+      // the transitions of a code point trie can't be enumerated cheaply
+      printf("no histograms for the %s format\n", format_name(format));
+    }
+  });
+}
+
+//
+// lookup
+//
+
+void run_lookup(const Options &options) {
+  auto &path = options.paths[0];
+  std::ifstream is(path, std::ios::binary);
+  if (!is)
+    fail("cannot open", path);
+
+  AnyTrie trie;
+  if (!trie.load(is))
+    fail("unknown format, saved without a format header?", path);
+
+  std::vector<std::string> lines;
+  std::vector<std::string_view> keys;
+  std::string out;
+
+  auto flush = [&] {
+    keys.assign(lines.begin(), lines.end());
+    auto values = trie.lookup(keys);
+
+    out.clear();
+    for (size_t i = 0; i < keys.size(); ++i) {
+      out += keys[i];
+      out += '\t';
+      if (!values[i])
+        out += '-';
+      else
+        out += trie.has_values() ? std::to_string(*values[i]) : "1";
+      out += '\n';
+    }
+    fwrite(out.data(), 1, out.size(), stdout);
+    lines.clear();
+  };
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    lines.push_back(std::move(line));
+    if (lines.size() == options.batch_size)
+      flush();
+  }
+  flush();
+}
+
+//
+// bench
+//
+
+template <typename Trie>
+concept HasFuzzySearch = requires(const Trie &trie, std::string_view q) {
+  trie.fuzzy_search(q, 1u, [](std::string_view, auto, uint32_t) {});
+};
+
+//! keys of a trie without lower_bound, by a walk of the children
+template <typename Trie>
+std::vector<std::string> list_keys(const Trie &trie) {
+  using state_type = decltype(trie.traverse("").state());
+
+  std::vector<std::string> res;
+  // state, its key, popped in key order
+  std::vector<std::pair<state_type, std::string>> stack{
+      {trie.traverse("").state(), ""}};
+  while (!stack.empty()) {
+    auto [state, key] = std::move(stack.back());
+    stack.pop_back();
+
+    if (trie.has_value_at(state))
+      res.push_back(key);
+
+    size_t first = stack.size();
+    trie.for_each_child(state, [&](char ch, state_type child) {
+      stack.push_back({child, key + ch});
+    });
+    std::reverse(stack.begin() + static_cast<ptrdiff_t>(first), stack.end());
+  }
+
+  return res;
+}
+
+void run_bench(const Options &options) {
+  auto &path = options.paths[0];
+  auto dataset = path.substr(path.find_last_of("/\\") + 1);
+
+  PerfCounters perf(options.counters);
+  Reporter reporter(options.report_format);
+
+  visit_trie(path, [&](const auto &trie, TrieFormat format) {
+    std::vector<std::string> words;
+    if (!options.lexicon.empty()) {
+      words = load_lexicon(options.lexicon.c_str());
+    } else if constexpr (requires { trie.lower_bound(""); }) {
+      for (auto it = trie.lower_bound(""); it != std::default_sentinel; ++it) {
+        words.emplace_back(it->key);
+      }
+    } else if constexpr (requires {
+                           trie.for_each_child(trie.traverse("").state(),
+                                               [](char, auto) {});
+                         }) {
+      words = list_keys(trie);
+    } else {
+      fail("keys can't be listed, give a --lexicon", path);
+    }
+    if (words.empty())
+      fail("no keys to draw queries from", path);
+
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    auto report = [&](Measurement m) {
+      m.backend = format_name(format);
+      m.dataset = dataset;
+      reporter.report(m);
+    };
+
+    for (auto *name : {"hit", "miss"}) {
+      QuerySet qs(name, name == std::string_view("hit")
+                            ? zipf_queries(words, options.n_queries)
+                            : miss_queries(words, options.n_queries));
+      report(measure(trie, qs, options.repetitions, perf));
+    }
+
+    if constexpr (HasFuzzySearch<std::remove_cvref_t<decltype(trie)>>) {
+      for (uint32_t k = 1; k <= options.fuzzy; ++k) {
+        QuerySet qs("fuzzy" + std::to_string(k),
+                    typo_queries(words, options.n_queries / 500 + 1, k));
+        report(measure_queries(qs, options.repetitions, perf,
+                               [&](std::string_view q) {
+                                 size_t n = 0;
+                                 trie.fuzzy_search(
+                                     q, k, [&](std::string_view, auto,
+                                               uint32_t) { ++n; });
+                                 return n;
+                               }));
+      }
+    }
+  });
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  auto options = parse_options(argc, argv);
+
+  if (options.command == "build") {
+    switch (options.format) {
+    case TrieFormat::DEFAULT:
+      run_build<DoubleArrayTrieBuilder<>, DefaultSerializer>(options);
+      break;
+    case TrieFormat::DEFAULT64:
+      run_build<DoubleArrayTrieBuilder<int64_t, -1>, DefaultSerializer>(
+          options);
+      break;
+    case TrieFormat::COMPACT:
+      run_build<DoubleArrayTrieBuilder<uint32_t, 0, true>, CompactSerializer>(
+          options);
+      break;
+    case TrieFormat::NO_VALUE:
+      run_build<DoubleArrayTrieBuilder<>, NoValueSerializer>(options);
+      break;
+    case TrieFormat::DAWG:
+      run_build<DawgDoubleArrayTrieBuilder<>, void>(options);
+      break;
+    case TrieFormat::PACKED:
+      run_build<DoubleArrayTrieBuilder<>, PackedSerializer<>>(options);
+      break;
+    case TrieFormat::PACKED64:
+      run_build<DoubleArrayTrieBuilder<int64_t, -1>, PackedSerializer<>>(
+          options);
+      break;
+    default:
+      run_build<DoubleArrayTrieBuilder<int, -1, false, Utf8Alphabet>,
+            WideSerializer>(options);
+      break;
+    }
+  } else if (options.command == "stats") {
+    run_stats(options);
+  } else if (options.command == "lookup") {
+    run_lookup(options);
+  } else if (options.command == "bench") {
+    run_bench(options);
+  } else {
+    usage(argv[0]);
+  }
+
+  return 0;
+}